@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Commands posted by the keyboard hook and the GUI, executed on the control thread.
+enum class RecorderCommand : uint8_t {
+    TOGGLE_RECORDING, PLAY_LAST, STOP_PLAYBACK, TOGGLE_MODE, EMERGENCY_STOP, TAKE_LOADED,
+    EDIT_RECORDING
+};
+
+// Operations carried by EDIT_RECORDING.
+enum class EditOp : uint8_t { CUT, REPEAT, SHIFT, SPLICE, APPEND, SAVE };
+
+// Bounded lock-free multi-producer queue (Vyukov). push() never blocks or allocates,
+// so it is safe to call from inside a low-level input hook.
+template <typename T, size_t Capacity>
+class CommandQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    struct Cell {
+        std::atomic<size_t> seq;
+        T value;
+    };
+
+    Cell cells[Capacity];
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+
+public:
+    CommandQueue() {
+        for (size_t i = 0; i < Capacity; ++i) cells[i].seq.store(i, std::memory_order_relaxed);
+    }
+
+    // Returns false when the queue is full; the command is dropped.
+    bool push(const T& v) {
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells[pos & (Capacity - 1)];
+            size_t seq = c.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    c.value = v;
+                    c.seq.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Positions: how many pushes have claimed a cell, and how many pops have
+    // completed. Every command pushed before a call to enqueuedCount() sits
+    // below the returned position.
+    size_t enqueuedCount() const { return enqueuePos.load(std::memory_order_acquire); }
+    size_t dequeuedCount() const { return dequeuePos.load(std::memory_order_acquire); }
+
+    bool pop(T& out) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Cell& c = cells[pos & (Capacity - 1)];
+            size_t seq = c.seq.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = c.value;
+                    c.seq.store(pos + Capacity, std::memory_order_release);
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = dequeuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+};
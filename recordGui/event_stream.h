@@ -0,0 +1,346 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include "recording.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Live event stream for other local processes (overlays, analytics).
+//
+// A fixed-size ring of StreamEvent slots lives in a named shared-memory region.
+// Producers claim a sequence number with one fetch_add and publish through a
+// per-slot seqlock, so capture never waits on anyone. Readers keep their own
+// cursor in their own memory: any number can attach, none of them is visible
+// to the writer, and a reader that falls more than a ring behind sees an
+// overrun count and skips ahead instead of holding capture back.
+//
+// A restarted recorder reformats the region in place under attached readers.
+// Every format bumps the header's generation (odd while formatting), and a
+// reader that sees it change starts over at the new stream's first event
+// instead of comparing its cursor with a head that went back to 0.
+
+static const uint32_t STREAM_MAGIC    = 0x52414C53;   // "SLAR"
+static const uint32_t STREAM_VERSION  = 2;
+static const uint32_t STREAM_CAPACITY = 1u << 16;     // slots, power of two
+
+enum StreamFlags : uint8_t { STREAM_CAPTURED = 0x1, STREAM_INJECTED = 0x2 };
+enum StreamButton : uint8_t { STREAM_BTN_NONE, STREAM_BTN_LEFT, STREAM_BTN_RIGHT, STREAM_BTN_MIDDLE };
+
+// Plain-old-data mirror of Action; the layout is part of the shared ABI.
+struct StreamEvent {
+    double time;
+    uint64_t seq;
+    uint32_t type;        // ActionType
+    uint32_t vkCode;
+    int32_t x, y;
+    float deltaX, deltaY;
+    int16_t scrollDx, scrollDy;
+    uint8_t button;       // StreamButton
+    uint8_t flags;        // StreamFlags
+    uint8_t reserved[2];
+};
+static_assert(sizeof(StreamEvent) == 48, "StreamEvent layout is shared between processes");
+
+inline StreamEvent toStreamEvent(const Action& a, uint8_t flags) {
+    StreamEvent e{};
+    e.time = a.time;
+    e.seq = a.seq;
+    e.type = static_cast<uint32_t>(a.type);
+    e.vkCode = a.vkCode;
+    e.x = a.x; e.y = a.y;
+    e.deltaX = static_cast<float>(a.deltaX);
+    e.deltaY = static_cast<float>(a.deltaY);
+    e.scrollDx = static_cast<int16_t>(a.scrollDx);
+    e.scrollDy = static_cast<int16_t>(a.scrollDy);
+    e.button = a.button == "left" ? STREAM_BTN_LEFT : a.button == "right" ? STREAM_BTN_RIGHT
+             : a.button == "middle" ? STREAM_BTN_MIDDLE : STREAM_BTN_NONE;
+    e.flags = flags;
+    return e;
+}
+
+struct alignas(64) StreamSlot {
+    std::atomic<uint64_t> version;   // 2*seq+1 while writing, 2*seq+2 once published
+    StreamEvent event;
+};
+
+struct alignas(64) StreamHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t slotSize;
+    std::atomic<uint64_t> generation;         // bumped by every format; odd while formatting
+    alignas(64) std::atomic<uint64_t> head;   // events claimed so far
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory atomics must be lock-free");
+
+// The ring itself, over memory that something else has mapped. Platform-neutral.
+class EventRing {
+    StreamHeader* header = nullptr;
+    StreamSlot* slots = nullptr;
+    uint64_t mask = 0;
+
+    static bool sameLayout(const StreamHeader* h) {
+        return h->magic == STREAM_MAGIC && h->version == STREAM_VERSION && h->slotSize == sizeof(StreamSlot);
+    }
+
+public:
+    static size_t bytesFor(uint32_t capacity) {
+        return sizeof(StreamHeader) + sizeof(StreamSlot) * capacity;
+    }
+
+    // Writer side: initialises a region of at least bytesFor(capacity) bytes.
+    // A region left by an earlier writer, possibly with readers still
+    // attached, is reformatted in place under the next generation.
+    void format(void* mem, uint32_t capacity) {
+        header = static_cast<StreamHeader*>(mem);
+        slots = reinterpret_cast<StreamSlot*>(header + 1);
+        mask = capacity - 1;
+        uint64_t gen = 0;
+        if (sameLayout(header)) {
+            gen = (header->generation.load(std::memory_order_relaxed) | 1) + 1;
+            header->generation.store(gen - 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            header->head.store(0, std::memory_order_relaxed);
+            for (uint32_t i = 0; i < capacity; ++i) slots[i].version.store(0, std::memory_order_relaxed);
+        } else {
+            new (mem) StreamHeader();
+            for (uint32_t i = 0; i < capacity; ++i) new (&slots[i]) StreamSlot{ {0}, {} };
+            gen = 2;
+        }
+        header->capacity = capacity;
+        header->slotSize = sizeof(StreamSlot);
+        header->version = STREAM_VERSION;
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = STREAM_MAGIC;
+        header->generation.store(gen, std::memory_order_release);
+    }
+
+    // Reader side: validates a region formatted by format(). `size` is what is
+    // actually mapped, so a corrupt header can't point readers past the view.
+    bool attach(void* mem, size_t size) {
+        auto* h = static_cast<StreamHeader*>(mem);
+        if (size < sizeof(StreamHeader) || h->magic != STREAM_MAGIC || h->version != STREAM_VERSION) return false;
+        if (h->slotSize != sizeof(StreamSlot) || h->capacity == 0 || (h->capacity & (h->capacity - 1)) != 0) return false;
+        if (size < bytesFor(h->capacity)) return false;
+        header = h;
+        slots = reinterpret_cast<StreamSlot*>(h + 1);
+        mask = h->capacity - 1;
+        return true;
+    }
+
+    bool valid() const { return header != nullptr; }
+    // The capacity this view was attached with; the header's copy can change under a reformat.
+    uint32_t capacity() const { return header ? static_cast<uint32_t>(mask + 1) : 0; }
+    uint64_t head() const { return header->head.load(std::memory_order_acquire); }
+    uint64_t generation() const { return header->generation.load(std::memory_order_acquire); }
+    // False once a reformat changed the capacity: the view no longer fits and must be reopened.
+    bool layoutCurrent() const { return header->capacity == mask + 1; }
+
+    // Wait-free for producers; safe from hooks and from several threads at once.
+    void publish(const StreamEvent& e) {
+        if (!header) return;
+        uint64_t seq = header->head.fetch_add(1, std::memory_order_acq_rel);
+        StreamSlot& s = slots[seq & mask];
+        s.version.store(2 * seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(&s.event, &e, sizeof(StreamEvent));
+        s.version.store(2 * seq + 2, std::memory_order_release);
+    }
+
+    const StreamSlot& slot(uint64_t seq) const { return slots[seq & mask]; }
+};
+
+// One reader's cursor. Lives entirely in the reader's process.
+class StreamReader {
+    const EventRing* ring = nullptr;
+    uint64_t cursor = 0;
+    uint64_t overruns = 0;
+    uint64_t gen = 0;
+    uint64_t restarts = 0;
+    bool stale = false;
+
+    // False while the writer is reformatting or after it changed the layout.
+    bool followGeneration() {
+        uint64_t g = ring->generation();
+        if (g == gen) return true;
+        if (g & 1) return false;
+        if (!ring->layoutCurrent()) { stale = true; return false; }
+        gen = g;
+        cursor = 0;
+        restarts++;
+        return true;
+    }
+
+public:
+    // fromNow = false replays whatever is still in the ring.
+    void attach(const EventRing& r, bool fromNow = true) {
+        ring = &r;
+        gen = r.generation() & ~uint64_t(1);
+        uint64_t h = r.head();
+        if (fromNow) cursor = h;
+        else cursor = h > r.capacity() ? h - r.capacity() : 0;
+    }
+
+    uint64_t position() const { return cursor; }
+    uint64_t overrunCount() const { return overruns; }
+    // Times the writer restarted (reformatted the region) since attach.
+    uint64_t restartCount() const { return restarts; }
+    // The writer restarted with a different capacity; reopen the stream.
+    bool needsReopen() const { return stale; }
+    uint64_t available() const {
+        if (!ring) return 0;
+        uint64_t h = ring->head();
+        return h > cursor ? h - cursor : 0;
+    }
+
+    // Zero-copy access to the next event, or nullptr if none is published yet.
+    // The pointer is into shared memory: check it with commit() after use.
+    const StreamEvent* peek() {
+        if (!ring || stale) return nullptr;
+        for (;;) {
+            if (!followGeneration()) return nullptr;
+            uint64_t h = ring->head();
+            if (h < cursor) return nullptr;           // reformat in progress; the generation changes next
+            if (h - cursor > ring->capacity()) {
+                overruns += h - cursor - ring->capacity();
+                cursor = h - ring->capacity();
+            }
+            if (cursor == h) return nullptr;
+            const StreamSlot& s = ring->slot(cursor);
+            uint64_t v = s.version.load(std::memory_order_acquire);
+            if (v == 2 * cursor + 2) return &s.event;
+            if (v < 2 * cursor + 2) return nullptr;   // producer still writing this slot
+            overruns++;                               // already lapped
+            cursor++;
+        }
+    }
+
+    // True if the event returned by peek() was not overwritten while in use.
+    // Advances the cursor either way; a false return counts as an overrun.
+    bool commit() {
+        const StreamSlot& s = ring->slot(cursor);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        bool ok = s.version.load(std::memory_order_relaxed) == 2 * cursor + 2 && ring->generation() == gen;
+        if (!ok) overruns++;
+        cursor++;
+        return ok;
+    }
+
+    // Copying convenience wrapper around peek()/commit().
+    bool read(StreamEvent& out) {
+        for (;;) {
+            const StreamEvent* e = peek();
+            if (!e) return false;
+            std::memcpy(&out, e, sizeof(StreamEvent));
+            if (commit()) return true;
+        }
+    }
+};
+
+// Owns the OS mapping. The recorder creates it; readers open it by name.
+// On Linux the name is a POSIX shm object (link with -lrt on older glibc).
+class SharedEventStream {
+    EventRing ringView;
+    void* mem = nullptr;
+    size_t size = 0;
+    bool owner = false;
+    std::string name;
+#ifdef _WIN32
+    HANDLE mapping = nullptr;
+#endif
+
+public:
+    SharedEventStream() = default;
+    SharedEventStream(const SharedEventStream&) = delete;
+    SharedEventStream& operator=(const SharedEventStream&) = delete;
+    ~SharedEventStream() { close(); }
+
+    bool create(const std::string& streamName, uint32_t capacity = STREAM_CAPACITY) {
+        close();
+        size = EventRing::bytesFor(capacity);
+        name = streamName;
+#ifdef _WIN32
+        std::wstring wname(streamName.begin(), streamName.end());
+        mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+                                     static_cast<DWORD>(static_cast<uint64_t>(size) >> 32), static_cast<DWORD>(size), wname.c_str());
+        if (!mapping) return false;
+        mem = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+        if (!mem) { close(); return false; }
+#else
+        // an object left by a crashed recorder is reused (and reformatted by
+        // format()); it is never shrunk under readers that still map it
+        int fd = shm_open(streamName.c_str(), O_CREAT | O_RDWR, 0600);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+        if (static_cast<size_t>(st.st_size) < size && ftruncate(fd, static_cast<off_t>(size)) != 0) { ::close(fd); return false; }
+        mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mem == MAP_FAILED) { mem = nullptr; return false; }
+#endif
+        owner = true;
+        ringView.format(mem, capacity);
+        return true;
+    }
+
+    bool open(const std::string& streamName) {
+        close();
+        name = streamName;
+#ifdef _WIN32
+        std::wstring wname(streamName.begin(), streamName.end());
+        mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, wname.c_str());
+        if (!mapping) return false;
+        mem = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!mem) { close(); return false; }
+        // the header can't be trusted for the size: ask the OS how much is mapped
+        MEMORY_BASIC_INFORMATION mbi;
+        if (!VirtualQuery(mem, &mbi, sizeof(mbi))) { close(); return false; }
+        size = mbi.RegionSize;
+#else
+        int fd = shm_open(streamName.c_str(), O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+        size = static_cast<size_t>(st.st_size);
+        mem = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (mem == MAP_FAILED) { mem = nullptr; return false; }
+#endif
+        if (!ringView.attach(mem, size)) { close(); return false; }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (mem) UnmapViewOfFile(mem);
+        if (mapping) CloseHandle(mapping);
+        mapping = nullptr;
+#else
+        if (mem) munmap(mem, size);
+        if (owner && !name.empty()) shm_unlink(name.c_str());
+#endif
+        mem = nullptr;
+        ringView = EventRing();
+        owner = false;
+    }
+
+    bool isOpen() const { return mem != nullptr; }
+    EventRing& ring() { return ringView; }
+
+    void publish(const Action& a, uint8_t flags) {
+        if (mem) ringView.publish(toStreamEvent(a, flags));
+    }
+};
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "recording.h"
+
+// Each capture source appends to its own track, so the hook thread and the raw
+// processor never contend and a late raw delta never lands in the middle of
+// another source's events.
+enum class EventSource : uint8_t { KEYBOARD, MOUSE_BUTTON, MOUSE_MOVE, RAW_DELTA, COUNT };
+
+constexpr size_t EVENT_SOURCE_COUNT = static_cast<size_t>(EventSource::COUNT);
+
+inline EventSource sourceOf(ActionType t) {
+    switch (t) {
+        case ActionType::KEY_PRESS:
+        case ActionType::KEY_RELEASE:   return EventSource::KEYBOARD;
+        case ActionType::MOUSE_MOVE:    return EventSource::MOUSE_MOVE;
+        case ActionType::MOUSE_DELTA:   return EventSource::RAW_DELTA;
+        default:                        return EventSource::MOUSE_BUTTON;
+    }
+}
+
+// (time, seq) is the total order of a recording.
+inline bool actionBefore(const Action& a, const Action& b) {
+    if (a.time != b.time) return a.time < b.time;
+    return a.seq < b.seq;
+}
+
+using TrackSnapshot = std::array<std::vector<Action>, EVENT_SOURCE_COUNT>;
+
+// Splits a merged take into per-source tracks. Relative order is kept.
+inline TrackSnapshot splitBySource(const std::vector<Action>& all) {
+    TrackSnapshot split;
+    for (const auto& a : all) split[static_cast<size_t>(sourceOf(a.type))].push_back(a);
+    return split;
+}
+
+class EventTracks {
+    struct Track {
+        mutable std::mutex m;
+        std::vector<Action> events;
+    };
+    std::array<Track, EVENT_SOURCE_COUNT> tracks;
+
+    // Whole-take operations hold every track at once so they never see (or
+    // leave) tracks from two different takes. append() takes only its own.
+    static_assert(EVENT_SOURCE_COUNT == 4, "allTracks() lists every track");
+    std::scoped_lock<std::mutex, std::mutex, std::mutex, std::mutex> allTracks() const {
+        return std::scoped_lock<std::mutex, std::mutex, std::mutex, std::mutex>(tracks[0].m, tracks[1].m, tracks[2].m, tracks[3].m);
+    }
+
+public:
+    void append(const Action& a) {
+        Track& t = tracks[static_cast<size_t>(sourceOf(a.type))];
+        std::lock_guard<std::mutex> lk(t.m);
+        t.events.push_back(a);
+    }
+
+    void clear() {
+        for (auto& t : tracks) { std::lock_guard<std::mutex> lk(t.m); t.events.clear(); }
+    }
+
+    size_t size() const {
+        size_t n = 0;
+        for (auto& t : tracks) { std::lock_guard<std::mutex> lk(t.m); n += t.events.size(); }
+        return n;
+    }
+
+    bool empty() const { return size() == 0; }
+
+    // Grows each empty track so a take of up to `perTrack` events never
+    // reallocates, and constructs into the new capacity once so its pages are
+    // faulted in now rather than by the first events of the take.
+    void prefault(size_t perTrack) {
+        for (auto& t : tracks) {
+            std::lock_guard<std::mutex> lk(t.m);
+            if (!t.events.empty()) continue;
+            t.events.resize(perTrack);
+            t.events.clear();
+        }
+    }
+
+    // fn(data, capacityBytes) for each track's buffer. fn runs under the
+    // track's mutex, which the capturing thread needs to append: keep it short.
+    template <typename Fn>
+    void forEachBuffer(Fn&& fn) const {
+        for (auto& t : tracks) {
+            std::lock_guard<std::mutex> lk(t.m);
+            fn(static_cast<const void*>(t.events.data()), t.events.capacity() * sizeof(Action));
+        }
+    }
+
+    // Replaces all tracks with the given events, split by source. Relative order is kept.
+    void assign(const std::vector<Action>& all) { assign(splitBySource(all)); }
+
+    // Replaces all tracks with an already split take; only swaps buffers.
+    void assign(TrackSnapshot&& split) {
+        auto lk = allTracks();
+        for (size_t i = 0; i < EVENT_SOURCE_COUNT; ++i) tracks[i].events.swap(split[i]);
+    }
+
+    TrackSnapshot snapshot() const {
+        TrackSnapshot out;
+        auto lk = allTracks();
+        for (size_t i = 0; i < EVENT_SOURCE_COUNT; ++i) out[i] = tracks[i].events;
+        return out;
+    }
+};
+
+// Streaming k-way merge. Every added sequence is cut into its maximal ascending
+// runs, and a binary heap over the run heads yields events in (time, seq) order.
+// Ties that survive (time, seq) go to the run added first, so the merge is stable.
+// n events in k runs cost O(n log k); an already sorted input is a single run.
+class TimelineMerger {
+    struct Run {
+        const Action* begin;
+        const Action* end;
+        const Action* cur;
+    };
+    std::vector<Run> runs;
+    std::vector<uint32_t> heap;   // indices into runs, min-heap on the run head
+
+    bool less(uint32_t a, uint32_t b) const {
+        const Action& x = *runs[a].cur;
+        const Action& y = *runs[b].cur;
+        if (actionBefore(x, y)) return true;
+        if (actionBefore(y, x)) return false;
+        return a < b;
+    }
+
+    void siftDown(size_t i) {
+        size_t n = heap.size();
+        for (;;) {
+            size_t l = 2 * i + 1, r = l + 1, m = i;
+            if (l < n && less(heap[l], heap[m])) m = l;
+            if (r < n && less(heap[r], heap[m])) m = r;
+            if (m == i) return;
+            std::swap(heap[i], heap[m]);
+            i = m;
+        }
+    }
+
+public:
+    void add(const std::vector<Action>& events) {
+        if (events.empty()) return;
+        const Action* p = events.data();
+        const Action* end = p + events.size();
+        const Action* runStart = p;
+        for (const Action* q = p + 1; q < end; ++q) {
+            if (actionBefore(*q, *(q - 1))) {
+                runs.push_back({runStart, q, runStart});
+                runStart = q;
+            }
+        }
+        runs.push_back({runStart, end, runStart});
+        reset();
+    }
+
+    void add(const TrackSnapshot& snap) {
+        for (const auto& t : snap) add(t);
+    }
+
+    // Rewinds to the first event; the underlying vectors must still be alive.
+    void reset() {
+        heap.clear();
+        for (uint32_t i = 0; i < runs.size(); ++i) {
+            runs[i].cur = runs[i].begin;
+            heap.push_back(i);
+        }
+        for (size_t i = heap.size() / 2; i-- > 0;) siftDown(i);
+    }
+
+    size_t runCount() const { return runs.size(); }
+
+    // Next event in time order, or nullptr when exhausted.
+    const Action* next() {
+        if (heap.empty()) return nullptr;
+        Run& r = runs[heap[0]];
+        const Action* out = r.cur++;
+        if (r.cur == r.end) {
+            heap[0] = heap.back();
+            heap.pop_back();
+        }
+        if (!heap.empty()) siftDown(0);
+        return out;
+    }
+};
+
+inline std::vector<Action> mergeTimeline(const TrackSnapshot& snap) {
+    TimelineMerger m;
+    m.add(snap);
+    std::vector<Action> out;
+    size_t n = 0;
+    for (const auto& t : snap) n += t.size();
+    out.reserve(n);
+    while (const Action* a = m.next()) out.push_back(*a);
+    return out;
+}
+
+// Sorts a possibly out-of-order legacy recording in O(n log k), k = ascending runs.
+inline void repairTimeline(std::vector<Action>& events) {
+    TimelineMerger m;
+    m.add(events);
+    if (m.runCount() <= 1) return;
+    std::vector<Action> out;
+    out.reserve(events.size());
+    while (const Action* a = m.next()) out.push_back(*a);
+    events.swap(out);
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "command_queue.h"
+#include "recording.h"
+
+#ifndef _WIN32
+#include <unistd.h>
+#endif
+
+// Injection latency: the time from an event's scheduled playback instant to the
+// moment the input stack delivers it. It differs per injection path (SendInput
+// vs mouse_event, the pre-click cursor move and sleep, scheduler wakeup), so it
+// is measured per kind and playback fires each event early by that amount.
+
+static const char* INJECTION_LATENCY_FILE = "injection_latency.json";
+
+enum class InjectKind : uint8_t { MOVE_ABSOLUTE, MOVE_RELATIVE, BUTTON_RIGHT, BUTTON_CLICK, KEY, COUNT };
+constexpr size_t INJECT_KIND_COUNT = static_cast<size_t>(InjectKind::COUNT);
+
+// What a loopback sink can tell apart when an injected event arrives.
+enum class ArrivalClass : uint8_t { MOVE, BUTTON, KEY, COUNT };
+constexpr size_t ARRIVAL_CLASS_COUNT = static_cast<size_t>(ArrivalClass::COUNT);
+
+using LatencyClock = std::chrono::steady_clock;
+
+// What the LL hooks hand over for each injected event they see. They only push
+// it into a lock-free queue; counting, waking and matching happen on the thread
+// that consumes it (calibration or playback).
+struct InjectedArrival {
+    ArrivalClass cls;
+    LatencyClock::time_point at;
+};
+static const size_t ARRIVAL_QUEUE_CAPACITY = 1024;   // far more than one probe or playback step produces
+using ArrivalQueue = CommandQueue<InjectedArrival, ARRIVAL_QUEUE_CAPACITY>;
+
+// Scroll goes through plain SendInput like a relative move.
+inline InjectKind injectKindOf(const Action& a) {
+    switch (a.type) {
+        case ActionType::MOUSE_MOVE:    return InjectKind::MOVE_ABSOLUTE;
+        case ActionType::MOUSE_PRESS:
+        case ActionType::MOUSE_RELEASE: return a.button == "right" ? InjectKind::BUTTON_RIGHT : InjectKind::BUTTON_CLICK;
+        case ActionType::KEY_PRESS:
+        case ActionType::KEY_RELEASE:   return InjectKind::KEY;
+        default:                        return InjectKind::MOVE_RELATIVE;
+    }
+}
+
+inline ArrivalClass arrivalClassOf(InjectKind k) {
+    switch (k) {
+        case InjectKind::BUTTON_RIGHT:
+        case InjectKind::BUTTON_CLICK: return ArrivalClass::BUTTON;
+        case InjectKind::KEY:          return ArrivalClass::KEY;
+        default:                       return ArrivalClass::MOVE;
+    }
+}
+
+inline const char* injectKindName(InjectKind k) {
+    switch (k) {
+        case InjectKind::MOVE_ABSOLUTE: return "move_absolute";
+        case InjectKind::MOVE_RELATIVE: return "move_relative";
+        case InjectKind::BUTTON_RIGHT:  return "button_right";
+        case InjectKind::BUTTON_CLICK:  return "button_click";
+        default:                        return "key";
+    }
+}
+
+inline const char* arrivalClassName(ArrivalClass c) {
+    switch (c) {
+        case ArrivalClass::MOVE:   return "move";
+        case ArrivalClass::BUTTON: return "button";
+        default:                   return "key";
+    }
+}
+
+struct LatencyProfile {
+    std::array<double, INJECT_KIND_COUNT> latency{};   // median, seconds
+    std::array<double, INJECT_KIND_COUNT> jitter{};    // p90 - p10, seconds
+    std::array<size_t, INJECT_KIND_COUNT> samples{};
+
+    bool measured(InjectKind k) const { return samples[static_cast<size_t>(k)] > 0; }
+    bool empty() const { return std::all_of(samples.begin(), samples.end(), [](size_t n) { return n == 0; }); }
+
+    // How much earlier than its recorded time an event of this kind should be sent.
+    double lead(InjectKind k) const { return measured(k) ? latency[static_cast<size_t>(k)] : 0.0; }
+
+    bool save(const std::string& path = INJECTION_LATENCY_FILE) const {
+        try {
+            nlohmann::json j;
+            for (size_t i = 0; i < INJECT_KIND_COUNT; ++i) {
+                const char* name = injectKindName(static_cast<InjectKind>(i));
+                j[name]["latency"] = latency[i];
+                j[name]["jitter"] = jitter[i];
+                j[name]["samples"] = samples[i];
+            }
+            std::ofstream f(path);
+            f << j.dump(2);
+            return static_cast<bool>(f);
+        } catch (...) { return false; }
+    }
+
+    bool load(const std::string& path = INJECTION_LATENCY_FILE) {
+        try {
+            std::ifstream f(path);
+            if (!f) return false;
+            nlohmann::json j = nlohmann::json::parse(f);
+            LatencyProfile p;
+            for (size_t i = 0; i < INJECT_KIND_COUNT; ++i) {
+                const char* name = injectKindName(static_cast<InjectKind>(i));
+                if (!j.contains(name)) continue;
+                p.latency[i] = j[name].value("latency", 0.0);
+                p.jitter[i] = j[name].value("jitter", 0.0);
+                p.samples[i] = j[name].value("samples", static_cast<size_t>(0));
+            }
+            *this = p;
+            return true;
+        } catch (...) { return false; }
+    }
+};
+
+// Timestamps injected input as it comes back. Whatever observes delivery (the
+// LL hooks on Windows, a pipe reader on the Linux stand-in) calls record(),
+// which is lock-free and never blocks. count() and waitAfter() belong to the
+// one thread waiting on arrivals; it drains the queue itself.
+class LoopbackSink {
+    ArrivalQueue queue;
+    std::array<uint64_t, ARRIVAL_CLASS_COUNT> counts{};
+    std::array<LatencyClock::time_point, ARRIVAL_CLASS_COUNT> last{};
+
+    void drain() {
+        InjectedArrival a;
+        while (queue.pop(a)) {
+            counts[static_cast<size_t>(a.cls)]++;
+            last[static_cast<size_t>(a.cls)] = a.at;
+        }
+    }
+
+public:
+    // Safe from the LL hooks. False if the queue was full and the arrival dropped.
+    bool record(ArrivalClass c, LatencyClock::time_point at = LatencyClock::now()) {
+        return queue.push({ c, at });
+    }
+
+    uint64_t count(ArrivalClass c) {
+        drain();
+        return counts[static_cast<size_t>(c)];
+    }
+
+    // Waits for the first arrival of class c after `seen` arrivals; returns its
+    // time. Polls: the timestamp comes from record(), so the poll interval only
+    // delays the waiter, not the measurement.
+    bool waitAfter(ArrivalClass c, uint64_t seen, std::chrono::milliseconds timeout, LatencyClock::time_point& at) {
+        size_t i = static_cast<size_t>(c);
+        auto deadline = LatencyClock::now() + timeout;
+        for (;;) {
+            drain();
+            if (counts[i] > seen) { at = last[i]; return true; }
+            if (LatencyClock::now() >= deadline) return false;
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+};
+
+// Sends `probes` events of every kind, each scheduled on an absolute deadline
+// exactly as playback would, and records how long after the deadline the sink
+// saw it. inject(kind, probeIndex) must emit exactly one event of the kind's
+// arrival class (alternate press/release so nothing is left held).
+template <typename Inject>
+LatencyProfile calibrateInjectionLatency(Inject&& inject, LoopbackSink& sink, size_t probes,
+                                         std::chrono::milliseconds spacing, const std::atomic<bool>& running) {
+    LatencyProfile profile;
+    for (size_t k = 0; k < INJECT_KIND_COUNT && running; ++k) {
+        InjectKind kind = static_cast<InjectKind>(k);
+        ArrivalClass cls = arrivalClassOf(kind);
+        std::vector<double> lat;
+        for (size_t i = 0; i < probes && running; ++i) {
+            uint64_t seen = sink.count(cls);
+            auto target = LatencyClock::now() + spacing;
+            std::this_thread::sleep_until(target);
+            inject(kind, i);
+            LatencyClock::time_point at;
+            if (sink.waitAfter(cls, seen, std::chrono::milliseconds(250), at)) {
+                lat.push_back(std::chrono::duration<double>(at - target).count());
+            }
+        }
+        if (lat.empty()) continue;
+        std::sort(lat.begin(), lat.end());
+        profile.latency[k] = lat[lat.size() / 2];
+        profile.jitter[k] = lat[lat.size() * 9 / 10] - lat[lat.size() / 10];
+        profile.samples[k] = lat.size();
+    }
+    return profile;
+}
+
+// Residual timing error during compensated playback: each injected event is
+// expected at its recorded instant, arrivals are matched to expectations in
+// FIFO order per class (the input stack delivers one class in order). Helper
+// events (the cursor move before a click) are expected uncounted so the FIFO
+// stays aligned. record() is lock-free and safe from the LL hooks; everything
+// else belongs to the playback thread, which matches arrivals in match().
+// Matching only what was queued after the expectation was pushed keeps a hook
+// that runs before SendInput returns from racing the expectation.
+class ResidualTracker {
+    struct Stats { size_t n = 0; double sum = 0.0, sumAbs = 0.0, maxAbs = 0.0; };
+    struct Expected { LatencyClock::time_point intended; bool counted; };
+    ArrivalQueue arrivals;
+    std::array<std::deque<Expected>, ARRIVAL_CLASS_COUNT> pending;
+    std::array<Stats, ARRIVAL_CLASS_COUNT> stats;
+
+public:
+    void reset() {
+        InjectedArrival stale;
+        while (arrivals.pop(stale)) {}
+        for (auto& q : pending) q.clear();
+        stats = {};
+    }
+
+    void expect(ArrivalClass c, LatencyClock::time_point intended, bool counted = true) {
+        auto& q = pending[static_cast<size_t>(c)];
+        if (q.size() < 4096) q.push_back({ intended, counted });
+    }
+
+    // Withdraws the latest expectation when the event turned out not to be sent.
+    void retract(ArrivalClass c) {
+        auto& q = pending[static_cast<size_t>(c)];
+        if (!q.empty()) q.pop_back();
+    }
+
+    // Safe from the LL hooks. False if the queue was full and the arrival dropped.
+    bool record(ArrivalClass c, LatencyClock::time_point at = LatencyClock::now()) {
+        return arrivals.push({ c, at });
+    }
+
+    // Pairs queued arrivals with expectations, in FIFO order per class.
+    void match() {
+        InjectedArrival a;
+        while (arrivals.pop(a)) {
+            auto& q = pending[static_cast<size_t>(a.cls)];
+            if (q.empty()) continue;
+            Expected e = q.front();
+            q.pop_front();
+            if (!e.counted) continue;
+            double err = std::chrono::duration<double>(a.at - e.intended).count();
+            Stats& s = stats[static_cast<size_t>(a.cls)];
+            s.n++;
+            s.sum += err;
+            s.sumAbs += std::abs(err);
+            s.maxAbs = std::max(s.maxAbs, std::abs(err));
+        }
+    }
+
+    // Per class: samples, mean signed error, mean and max absolute error (seconds).
+    struct Summary { size_t samples; double mean, meanAbs, maxAbs; };
+    Summary summary(ArrivalClass c) {
+        match();
+        const Stats& s = stats[static_cast<size_t>(c)];
+        if (!s.n) return { 0, 0.0, 0.0, 0.0 };
+        return { s.n, s.sum / s.n, s.sumAbs / s.n, s.maxAbs };
+    }
+};
+
+#ifndef _WIN32
+// Linux stand-in for the input stack: "injecting" writes the arrival class to
+// a pipe and a reader thread timestamps it on wakeup, so calibration exercises
+// real syscall and scheduler latency without a display server. Used by
+// tools/injection_latency_bench.cpp.
+class PipeLoopback {
+    int fds[2] = { -1, -1 };
+    std::thread reader;
+    LoopbackSink& sink;
+
+public:
+    explicit PipeLoopback(LoopbackSink& s) : sink(s) {}
+    PipeLoopback(const PipeLoopback&) = delete;
+    PipeLoopback& operator=(const PipeLoopback&) = delete;
+    ~PipeLoopback() { stop(); }
+
+    bool start() {
+        if (pipe(fds) != 0) return false;
+        reader = std::thread([this]() {
+            uint8_t c;
+            while (::read(fds[0], &c, 1) == 1) sink.record(static_cast<ArrivalClass>(c));
+        });
+        return true;
+    }
+
+    void send(ArrivalClass c) {
+        uint8_t b = static_cast<uint8_t>(c);
+        if (::write(fds[1], &b, 1) != 1) {}
+    }
+
+    void stop() {
+        if (fds[1] >= 0) { ::close(fds[1]); fds[1] = -1; }
+        if (reader.joinable()) reader.join();
+        if (fds[0] >= 0) { ::close(fds[0]); fds[0] = -1; }
+    }
+};
+#endif
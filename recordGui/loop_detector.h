@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <vector>
+#include "recording.h"
+#include "recording_slice.h"
+
+static const double LOOP_BIN_SEC       = 0.02;   // resampling grid
+static const double LOOP_MIN_PERIOD    = 1.0;    // shortest cycle worth proposing, seconds
+static const double LOOP_HELD_PENALTY  = 50.0;   // px-equivalent cost per key held across a cut
+static const double LOOP_MIN_CORRELATION = 0.3;  // weaker peaks are noise, not a cycle
+
+struct LoopCandidate {
+    bool found = false;
+    double period = 0.0;       // seconds
+    double start = 0.0;        // seconds into the source recording
+    double correlation = 0.0;  // normalized autocorrelation at the period, 0..1
+    double netDx = 0.0, netDy = 0.0;
+    size_t heldAtCut = 0;
+};
+
+namespace loop_detail {
+
+// In-place iterative radix-2 FFT; a.size() must be a power of two.
+inline void fft(std::vector<std::complex<double>>& a, bool inverse) {
+    const size_t n = a.size();
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(a[i], a[j]);
+    }
+    const double PI = 3.14159265358979323846;
+    for (size_t len = 2; len <= n; len <<= 1) {
+        double ang = 2.0 * PI / static_cast<double>(len) * (inverse ? 1.0 : -1.0);
+        std::complex<double> wlen(std::cos(ang), std::sin(ang));
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<double> w(1.0, 0.0);
+            for (size_t k = 0; k < len / 2; ++k) {
+                std::complex<double> u = a[i + k], v = a[i + k + len / 2] * w;
+                a[i + k] = u + v;
+                a[i + k + len / 2] = u - v;
+                w *= wlen;
+            }
+        }
+    }
+    if (inverse) for (auto& x : a) x /= static_cast<double>(n);
+}
+
+// Biased autocorrelation normalized to r[0] = 1, via |FFT|^2 with zero padding.
+// Returns an empty vector for a constant signal.
+inline std::vector<double> autocorrelation(const std::vector<double>& x) {
+    const size_t n = x.size();
+    double mean = 0.0;
+    for (double v : x) mean += v;
+    mean /= static_cast<double>(n);
+    size_t size = 1;
+    while (size < 2 * n) size <<= 1;
+    std::vector<std::complex<double>> buf(size);
+    for (size_t i = 0; i < n; ++i) buf[i] = x[i] - mean;
+    fft(buf, false);
+    for (auto& c : buf) c = std::norm(c);
+    fft(buf, true);
+    double r0 = buf[0].real();
+    if (r0 <= 1e-12) return {};
+    std::vector<double> r(n);
+    for (size_t i = 0; i < n; ++i) r[i] = buf[i].real() / r0;
+    return r;
+}
+
+} // namespace loop_detail
+
+// Finds the dominant repeating period of a time-ordered recording and the best
+// single cycle to cut. Mouse dx/dy and key activity are resampled onto a
+// LOOP_BIN_SEC grid; their autocorrelations (O(n log n) each) are averaged and
+// the strongest peak past LOOP_MIN_PERIOD is the period if it reaches
+// LOOP_MIN_CORRELATION (the biased estimate of an exact repeat over at least
+// two cycles is 0.5 or more; noise stays near 0). The cut start minimises
+// the cycle's net displacement plus a penalty for keys held across either cut.
+inline LoopCandidate detectLoop(const std::vector<Action>& events) {
+    using namespace loop_detail;
+    LoopCandidate best;
+    if (events.size() < 2) return best;
+    double t0 = events.front().time;
+    size_t n = static_cast<size_t>((events.back().time - t0) / LOOP_BIN_SEC) + 1;
+    size_t minLag = static_cast<size_t>(LOOP_MIN_PERIOD / LOOP_BIN_SEC);
+    if (n < 2 * minLag + 2) return best;
+
+    std::vector<double> dx(n, 0.0), dy(n, 0.0), keys(n, 0.0), held(n + 1, 0.0);
+    HeldState state;
+    size_t e = 0;
+    for (size_t b = 0; b < n; ++b) {
+        double binEnd = t0 + (b + 1) * LOOP_BIN_SEC;
+        held[b] = static_cast<double>(state.count());
+        for (; e < events.size() && events[e].time < binEnd; ++e) {
+            const Action& a = events[e];
+            switch (a.type) {
+                case ActionType::MOUSE_MOVE:
+                case ActionType::MOUSE_DELTA:
+                    dx[b] += a.deltaX; dy[b] += a.deltaY; break;
+                case ActionType::KEY_PRESS:
+                case ActionType::MOUSE_PRESS:
+                    keys[b] += 1.0; break;
+                case ActionType::KEY_RELEASE:
+                case ActionType::MOUSE_RELEASE:
+                    keys[b] -= 1.0; break;
+                default: break;
+            }
+            state.apply(a);
+        }
+    }
+    held[n] = static_cast<double>(state.count());
+
+    std::vector<double> combined(n, 0.0);
+    int channels = 0;
+    for (const auto* ch : { &dx, &dy, &keys }) {
+        std::vector<double> r = autocorrelation(*ch);
+        if (r.empty()) continue;
+        for (size_t i = 0; i < n; ++i) combined[i] += r[i];
+        channels++;
+    }
+    if (channels == 0) return best;
+    for (double& v : combined) v /= channels;
+
+    size_t lag = 0;
+    double peak = 0.0;
+    for (size_t i = minLag; i <= n / 2; ++i) {
+        bool localMax = combined[i] >= combined[i - 1] && (i + 1 >= n || combined[i] >= combined[i + 1]);
+        if (localMax && combined[i] > peak) { peak = combined[i]; lag = i; }
+    }
+    if (lag == 0 || peak < LOOP_MIN_CORRELATION) return best;
+
+    // prefix sums make every window's net displacement O(1)
+    std::vector<double> px(n + 1, 0.0), py(n + 1, 0.0);
+    for (size_t i = 0; i < n; ++i) { px[i + 1] = px[i] + dx[i]; py[i + 1] = py[i] + dy[i]; }
+    double bestCost = 0.0;
+    size_t bestStart = 0;
+    for (size_t s = 0; s + lag <= n; ++s) {
+        double ndx = px[s + lag] - px[s], ndy = py[s + lag] - py[s];
+        double cost = std::hypot(ndx, ndy) + LOOP_HELD_PENALTY * (held[s] + held[s + lag]);
+        if (s == 0 || cost < bestCost) { bestCost = cost; bestStart = s; }
+    }
+
+    best.found = true;
+    best.period = lag * LOOP_BIN_SEC;
+    best.start = t0 + bestStart * LOOP_BIN_SEC;
+    best.correlation = peak;
+    best.netDx = px[bestStart + lag] - px[bestStart];
+    best.netDy = py[bestStart + lag] - py[bestStart];
+    best.heldAtCut = static_cast<size_t>(held[bestStart] + held[bestStart + lag]);
+    return best;
+}
+
+inline std::vector<Action> extractLoop(const std::vector<Action>& events, const LoopCandidate& c) {
+    if (!c.found) return {};
+    return sliceRecording(events, c.start, c.start + c.period);
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "recording.h"
+
+// Constants of the raw-delta smoothing algorithm, mirrored from the TUNING_*
+// statics so the live processor and the offline tuner run the same code.
+struct SmootherParams {
+    double alpha = 0.70;        // TUNING_SMOOTH_ALPHA
+    int stopThreshold = 1;      // TUNING_STOP_THRESHOLD
+    int stopFrames = 2;         // TUNING_STOP_FRAMES
+    int tickMs = 4;             // RAW_TICK_MS
+    int rampMs = 40;            // STOP_RAMP_MS
+    double rampDecay = 0.45;    // RAMP_DECAY
+    bool ramp = true;           // ENABLE_PLAYBACK_RAMP
+    double sensX = 1.0, sensY = 1.0;
+};
+
+// Exponential smoothing of raw mouse deltas with stop detection: once enough
+// consecutive small deltas (or idle ticks) are seen, the remaining velocity is
+// bled off in a geometric ramp instead of stopping dead.
+class RawSmoother {
+    SmootherParams p;
+    double smoothedX = 0.0, smoothedY = 0.0;
+    int consecutiveSmall = 0;
+    bool stopped = false;
+    std::deque<std::pair<int,int>> recent;
+    static constexpr size_t RECENT_MAX = 6;
+
+public:
+    explicit RawSmoother(const SmootherParams& params) : p(params) {}
+
+    // One tick of the processor loop with nothing queued.
+    void idleTick() { consecutiveSmall++; }
+
+    // emit(const Action&) receives each smoothed delta and ramp step.
+    template <typename Emit>
+    void feed(const RawDelta& rd, Emit&& emit) {
+        int dx = rd.dx, dy = rd.dy;
+        recent.push_back({dx,dy});
+        if (recent.size() > RECENT_MAX) recent.pop_front();
+
+        int absVal = std::max(std::abs(dx), std::abs(dy));
+        if (absVal <= p.stopThreshold) {
+            consecutiveSmall++;
+        } else {
+            consecutiveSmall = 0;
+        }
+
+        if (consecutiveSmall >= p.stopFrames) {
+            if (!stopped) {
+                double avgX = 0.0, avgY = 0.0;
+                if (!recent.empty()) {
+                    for (auto &r : recent) { avgX += r.first; avgY += r.second; }
+                    avgX /= static_cast<double>(recent.size());
+                    avgY /= static_cast<double>(recent.size());
+                }
+                if (p.ramp) {
+                    int rampSteps = std::max(1, p.rampMs / p.tickMs);
+                    double startX = smoothedX == 0.0 ? avgX : smoothedX;
+                    double startY = smoothedY == 0.0 ? avgY : smoothedY;
+                    double t0 = rd.time;
+                    for (int k = 1; k <= rampSteps; ++k) {
+                        double fracPrev = std::pow(p.rampDecay, (double)(k-1));
+                        double fracCurr = std::pow(p.rampDecay, (double)k);
+                        Action ra;
+                        ra.type = ActionType::MOUSE_DELTA;
+                        ra.deltaX = startX * (fracPrev - fracCurr) * p.sensX;
+                        ra.deltaY = startY * (fracPrev - fracCurr) * p.sensY;
+                        ra.time = t0 + (k * p.tickMs) / 1000.0;
+                        ra.isRawDelta = true;
+                        ra.seq = rd.seq;
+                        emit(ra);
+                    }
+                }
+                smoothedX = 0.0;
+                smoothedY = 0.0;
+                stopped = true;
+            }
+        } else {
+            stopped = false;
+            smoothedX = p.alpha * static_cast<double>(dx) + (1.0 - p.alpha) * smoothedX;
+            smoothedY = p.alpha * static_cast<double>(dy) + (1.0 - p.alpha) * smoothedY;
+            Action a;
+            a.type = ActionType::MOUSE_DELTA;
+            a.deltaX = smoothedX * p.sensX;
+            a.deltaY = smoothedY * p.sensY;
+            a.time = rd.time;
+            a.isRawDelta = true;
+            a.seq = rd.seq;
+            emit(a);
+        }
+    }
+};
+
+// Raw-delta log saved next to a recording ("<recording>.raw") for offline tuning.
+inline std::string rawLogPath(const std::string& recordingPath) { return recordingPath + ".raw"; }
+
+inline bool writeRawLog(const std::string& recordingPath, const std::vector<RawDelta>& log) {
+    std::ofstream f(rawLogPath(recordingPath), std::ios::binary);
+    uint64_t n = log.size();
+    f.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    for (const auto& rd : log) {
+        int32_t d[2] = { rd.dx, rd.dy };
+        f.write(reinterpret_cast<const char*>(d), sizeof(d));
+        f.write(reinterpret_cast<const char*>(&rd.time), sizeof(rd.time));
+    }
+    return static_cast<bool>(f);
+}
+
+inline bool readRawLog(const std::string& recordingPath, std::vector<RawDelta>& out) {
+    std::ifstream f(rawLogPath(recordingPath), std::ios::binary);
+    uint64_t n = 0;
+    if (!f.read(reinterpret_cast<char*>(&n), sizeof(n)) || n > (1ull << 32)) return false;
+    out.clear();
+    out.reserve(static_cast<size_t>(n));
+    for (uint64_t i = 0; i < n; ++i) {
+        int32_t d[2];
+        double t;
+        if (!f.read(reinterpret_cast<char*>(d), sizeof(d)) || !f.read(reinterpret_cast<char*>(&t), sizeof(t))) return false;
+        out.push_back({ d[0], d[1], t, i });
+    }
+    return true;
+}
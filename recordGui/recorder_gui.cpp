@@ -16,6 +16,23 @@
 #include <cmath>
 #include <unordered_set>
 #include <algorithm>
+#include <memory>
+#include <functional>
+#include <condition_variable>
+#include "command_queue.h"
+#include "recording.h"
+#include "event_tracks.h"
+#include "recording_io.h"
+#include "recording_analytics.h"
+#include "loop_detector.h"
+#include "recording_diff.h"
+#include "event_stream.h"
+#include "trajectory_pyramid.h"
+#include "raw_smoother.h"
+#include "smoothing_tuner.h"
+#include "recording_editor.h"
+#include "thread_policy.h"
+#include "injection_latency.h"
 
 #pragma comment(lib, "comctl32.lib")
 
@@ -38,6 +55,34 @@ namespace fs = std::filesystem;
 // NEW IDs for loop controls
 #define IDC_BTN_LOOP            1012
 #define IDC_EDIT_LOOP_COUNT     1013
+#define IDC_STATIC_ANALYTICS    1014
+#define IDC_BTN_FIND_LOOP       1015
+#define IDC_BTN_DIFF            1016
+#define IDC_PREVIEW             1017
+#define IDC_BTN_TUNE            1018
+#define IDC_EDIT_FROM           1019
+#define IDC_EDIT_TO             1020
+#define IDC_EDIT_AMOUNT         1021
+#define IDC_BTN_CUT             1022
+#define IDC_BTN_REPEAT          1023
+#define IDC_BTN_SHIFT           1024
+#define IDC_BTN_SPLICE          1025
+#define IDC_BTN_APPEND          1026
+#define IDC_BTN_SAVE_EDIT       1027
+#define IDC_BTN_CALIBRATE       1028
+
+static const size_t LATENCY_PROBES = 20;          // per injection kind, even so presses are released
+static const int LATENCY_PROBE_SPACING_MS = 30;
+
+// Posted by the control/playback threads so GUI work stays on the GUI thread
+#define WM_RECORDER_NOTIFY      (WM_APP + 1)
+#define NOTIFY_STATUS           0x1
+#define NOTIFY_LIST             0x2
+#define NOTIFY_ANALYTICS        0x4
+#define NOTIFY_PREVIEW          0x8
+
+// Shared-memory name of the live event stream (see event_stream.h)
+#define LIVE_STREAM_NAME        "Local\\RecordAllEventStream"
 
 // Tunable parameters
 static float TUNING_SENSITIVITY         = 1.00f;
@@ -52,36 +97,16 @@ static bool   ENABLE_PLAYBACK_RAMP      = true;
 static double RAW_SENS_X = 1.0;
 static double RAW_SENS_Y = 1.0;
 
-enum class ActionType {
-    MOUSE_MOVE, MOUSE_DELTA, MOUSE_PRESS, MOUSE_RELEASE, MOUSE_SCROLL,
-    KEY_PRESS, KEY_RELEASE
-};
-
-struct Action {
-    ActionType type;
-    int x = 0, y = 0;
-    double deltaX = 0.0, deltaY = 0.0;
-    std::string button;
-    std::string key;
-    DWORD vkCode = 0;
-    int scrollDx = 0, scrollDy = 0;
-    double time = 0.0;
-    bool isRawDelta = false;
-};
-
-struct RawDelta {
-    int dx, dy;
-    double time;
-};
-
 class KeyboardMouseRecorder {
 private:
-    bool recording = false;
-    bool loopPlayback = false;
+    std::atomic<bool> recording{false};
+    std::atomic<bool> loopPlayback{false};
     bool shouldExit = false;
-    bool playbackRunning = false;
-    bool recordOnMoveAlways = false;
-    std::vector<Action> actions;
+    std::atomic<bool> playbackRunning{false};
+    std::atomic<bool> recordOnMoveAlways{false};
+    EventTracks tracks;
+    std::atomic<uint64_t> captureSeq{0};
+    SharedEventStream liveStream;
     std::chrono::steady_clock::time_point startTime;
     std::chrono::steady_clock::time_point recordStartTime;
     HHOOK mouseHook = nullptr;
@@ -93,15 +118,78 @@ private:
     bool isRightButtonPressed = false;
     static KeyboardMouseRecorder* instance;
 
-    std::mutex actionsMutex;
     std::mutex rawMutex;
     std::deque<RawDelta> rawQueue;
     std::atomic<bool> rawProcessorRunning{false};
     std::thread rawProcessorThread;
+    std::vector<RawDelta> rawLog;   // unsmoothed input of the current take, for the tuner
+
+    // Affinity/priority per engine thread and buffer locking, from thread_policy.json.
+    ThreadPolicyConfig threadPolicy;
+    LockedBuffers lockedTracks;   // track buffers pinned for the current take; control thread only
+    LockedBuffers lockedRaw;      // rawLog; owned by the raw processor thread while it runs
+
+    // Injection latency. The LL hooks see our own injected input: during
+    // calibration they feed latencySink, during playback the residual tracker.
+    LatencyProfile latencyProfile;   // written by the job thread only while nothing plays
+    LoopbackSink latencySink;
+    ResidualTracker residuals;
+    std::atomic<bool> calibrating{false};
 
     // NEW: loop config
-    int loopTimes = 1;        // number of times to loop; 0 = infinite when loopEnabled true
-    bool loopEnabled = false; // whether looping is requested
+    std::atomic<int> loopTimes{1};        // number of times to loop; 0 = infinite when loopEnabled true
+    std::atomic<bool> loopEnabled{false}; // whether looping is requested
+
+    // Control plane: hooks and GUI only post commands, the control thread runs them.
+    // Commands execute in FIFO order. ESC records the queue position it was
+    // pressed at and sets emergencyRequested; the control thread then discards
+    // everything queued below that position and stops immediately. Commands
+    // posted after it run normally. A position needs no queue slot, so this
+    // holds even when the queue is full.
+    CommandQueue<RecorderCommand, 64> commands;
+    std::atomic<bool> emergencyRequested{false};
+    std::atomic<size_t> emergencyCutoff{0};
+    std::atomic<bool> controlRunning{false};
+    std::thread controlThread;
+    HANDLE commandEvent = nullptr;
+    std::mutex sessionMutex;   // serializes starting a take, a playback or a calibration
+
+    // Jobs: file parsing, analytics, loop search, diff, auto-tune, saving and
+    // calibration run in FIFO order on one worker at normal priority, so the
+    // control thread only makes state transitions and F1/F2/F3 never wait
+    // behind them. Results that replace control-owned state (tracks, editor)
+    // come back as a LoadedTake and are swapped in by TAKE_LOADED.
+    std::mutex jobMutex;
+    std::condition_variable jobCv;
+    std::deque<std::function<void()>> jobs;   // guarded by jobMutex
+    bool jobsRunning = false;                 // guarded by jobMutex
+    std::thread jobThread;
+
+    struct LoadedTake {
+        std::shared_ptr<const EditSource> source;
+        std::string name;
+        TrackSnapshot split;   // new playback tracks when replaceTracks is set
+        bool replaceTracks;
+    };
+
+    // Editing. The editor is owned by the control thread and starts from the
+    // last loaded or recorded take; edits are compiled into `tracks` only when
+    // played or saved.
+    struct PendingEdit {
+        EditOp op;
+        double from, to, amount;
+        std::shared_ptr<const EditSource> insert;   // SPLICE/APPEND: the take to insert, parsed by the job thread
+    };
+    std::mutex pendingMutex;
+    std::deque<LoadedTake> loadedTakes;     // guarded by pendingMutex
+    std::deque<PendingEdit> pendingEdits;   // guarded by pendingMutex
+    RecordingEditor editor;
+    std::string editBaseName;
+    bool editDirty = false;
+
+    std::mutex analyticsMutex;
+    std::wstring analyticsText;
+    std::shared_ptr<TrajectoryPyramid> previewPyramid;   // guarded by analyticsMutex
 
     double getCurrentTime() {
         if (recording) {
@@ -112,6 +200,12 @@ private:
         return 0.0;
     }
 
+    // Every captured event goes to its track and to live stream readers.
+    void capture(const Action& a) {
+        tracks.append(a);
+        liveStream.publish(a, STREAM_CAPTURED);
+    }
+
     std::string getButtonName(UINT mouseMsg) {
         if (mouseMsg == WM_LBUTTONDOWN || mouseMsg == WM_LBUTTONUP) return "left";
         if (mouseMsg == WM_RBUTTONDOWN || mouseMsg == WM_RBUTTONUP) return "right";
@@ -147,7 +241,7 @@ private:
                 int deltaX = raw->data.mouse.lLastX;
                 int deltaY = raw->data.mouse.lLastY;
                 if ((deltaX != 0 || deltaY != 0) && (instance->isRightButtonPressed || instance->recordOnMoveAlways)) {
-                    RawDelta rd{ deltaX, deltaY, instance->getCurrentTime() };
+                    RawDelta rd{ deltaX, deltaY, instance->getCurrentTime(), instance->captureSeq++ };
                     std::lock_guard<std::mutex> lk(instance->rawMutex);
                     instance->rawQueue.push_back(rd);
                 }
@@ -175,15 +269,30 @@ private:
         RegisterRawInputDevices(rid, 1, sizeof(RAWINPUTDEVICE));
     }
 
+    static SmootherParams currentSmootherParams() {
+        SmootherParams p;
+        p.alpha = TUNING_SMOOTH_ALPHA;
+        p.stopThreshold = TUNING_STOP_THRESHOLD;
+        p.stopFrames = TUNING_STOP_FRAMES;
+        p.tickMs = RAW_TICK_MS;
+        p.rampMs = STOP_RAMP_MS;
+        p.rampDecay = RAMP_DECAY;
+        p.ramp = ENABLE_PLAYBACK_RAMP;
+        p.sensX = RAW_SENS_X;
+        p.sensY = RAW_SENS_Y;
+        return p;
+    }
+
     void startRawProcessor() {
         rawProcessorRunning = true;
+        rawLog.clear();
+        rawLog.resize(threadPolicy.prefaultEvents);   // faults the pages in; capacity is kept
+        rawLog.clear();
         rawProcessorThread = std::thread([this]() {
-            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
-            double smoothedX = 0.0, smoothedY = 0.0;
-            int consecutiveSmall = 0;
-            bool stopped = false;
-            std::deque<std::pair<int,int>> recent;
-            const size_t RECENT_MAX = 6;
+            applyThreadPolicy(threadPolicy.processing);
+            RawSmoother smoother(currentSmootherParams());
+            bool lock = threadPolicy.lockMemory;
+            if (lock) lockedRaw.refresh(0, rawLog.data(), rawLog.capacity() * sizeof(RawDelta));
 
             while (rawProcessorRunning) {
                 RawDelta rd;
@@ -198,70 +307,14 @@ private:
                 }
                 if (!have) {
                     std::this_thread::sleep_for(std::chrono::milliseconds(RAW_TICK_MS));
-                    consecutiveSmall++;
+                    smoother.idleTick();
                     continue;
                 }
-                int dx = rd.dx, dy = rd.dy;
-                recent.push_back({dx,dy});
-                if (recent.size() > RECENT_MAX) recent.pop_front();
-
-                int absVal = std::max(std::abs(dx), std::abs(dy));
-                if (absVal <= TUNING_STOP_THRESHOLD) {
-                    consecutiveSmall++;
-                } else {
-                    consecutiveSmall = 0;
-                }
-
-                if (consecutiveSmall >= TUNING_STOP_FRAMES) {
-                    if (!stopped) {
-                        double avgX = 0.0, avgY = 0.0;
-                        if (!recent.empty()) {
-                            for (auto &p : recent) { avgX += p.first; avgY += p.second; }
-                            avgX /= static_cast<double>(recent.size());
-                            avgY /= static_cast<double>(recent.size());
-                        }
-                        if (ENABLE_PLAYBACK_RAMP) {
-                            int rampSteps = std::max(1, STOP_RAMP_MS / RAW_TICK_MS);
-                            double startX = smoothedX == 0.0 ? avgX : smoothedX;
-                            double startY = smoothedY == 0.0 ? avgY : smoothedY;
-                            double t0 = rd.time;
-                            for (int k = 1; k <= rampSteps; ++k) {
-                                double fracPrev = std::pow(RAMP_DECAY, (double)(k-1));
-                                double fracCurr = std::pow(RAMP_DECAY, (double)k);
-                                double stepX = startX * (fracPrev - fracCurr);
-                                double stepY = startY * (fracPrev - fracCurr);
-                                Action ra;
-                                ra.type = ActionType::MOUSE_DELTA;
-                                ra.deltaX = stepX * RAW_SENS_X;
-                                ra.deltaY = stepY * RAW_SENS_Y;
-                                ra.time = t0 + (k * RAW_TICK_MS) / 1000.0;
-                                ra.isRawDelta = true;
-                                {
-                                    std::lock_guard<std::mutex> lk(actionsMutex);
-                                    actions.push_back(ra);
-                                }
-                            }
-                        }
-                        smoothedX = 0.0;
-                        smoothedY = 0.0;
-                        stopped = true;
-                    }
-                } else {
-                    stopped = false;
-                    smoothedX = TUNING_SMOOTH_ALPHA * static_cast<double>(dx) + (1.0 - TUNING_SMOOTH_ALPHA) * smoothedX;
-                    smoothedY = TUNING_SMOOTH_ALPHA * static_cast<double>(dy) + (1.0 - TUNING_SMOOTH_ALPHA) * smoothedY;
-                    Action a;
-                    a.type = ActionType::MOUSE_DELTA;
-                    a.deltaX = smoothedX * RAW_SENS_X;
-                    a.deltaY = smoothedY * RAW_SENS_Y;
-                    a.time = rd.time;
-                    a.isRawDelta = true;
-                    {
-                        std::lock_guard<std::mutex> lk(actionsMutex);
-                        actions.push_back(a);
-                    }
-                }
+                rawLog.push_back(rd);
+                if (lock) lockedRaw.refresh(0, rawLog.data(), rawLog.capacity() * sizeof(RawDelta));
+                smoother.feed(rd, [this](const Action& a) { capture(a); });
             }
+            lockedRaw.release(0, rawLog.data(), rawLog.capacity() * sizeof(RawDelta));
         });
     }
 
@@ -270,11 +323,24 @@ private:
         if (rawProcessorThread.joinable()) rawProcessorThread.join();
     }
 
+    // Called from the LL hooks: only a timestamp and a lock-free push. The
+    // calibration and playback threads drain and match the queues themselves.
+    void onInjectedArrival(ArrivalClass c) {
+        auto now = LatencyClock::now();
+        if (calibrating) latencySink.record(c, now);
+        else if (playbackRunning) residuals.record(c, now);
+    }
+
     static LRESULT CALLBACK MouseHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
+        if (nCode >= 0 && instance && (reinterpret_cast<MSLLHOOKSTRUCT*>(lParam)->flags & LLMHF_INJECTED)) {
+            bool move = wParam == WM_MOUSEMOVE || wParam == WM_MOUSEWHEEL;
+            instance->onInjectedArrival(move ? ArrivalClass::MOVE : ArrivalClass::BUTTON);
+        }
         if (nCode >= 0 && instance && instance->recording) {
             MSLLHOOKSTRUCT* mouseInfo = reinterpret_cast<MSLLHOOKSTRUCT*>(lParam);
             Action action;
             action.time = instance->getCurrentTime();
+            action.seq = instance->captureSeq++;
             action.isRawDelta = false;
             POINT cursorPos;
             GetCursorPos(&cursorPos);
@@ -287,8 +353,7 @@ private:
                         action.type = ActionType::MOUSE_MOVE;
                         action.deltaX = static_cast<double>(cursorPos.x - instance->lastMousePos.x);
                         action.deltaY = static_cast<double>(cursorPos.y - instance->lastMousePos.y);
-                        std::lock_guard<std::mutex> lk(instance->actionsMutex);
-                        instance->actions.push_back(action);
+                        instance->capture(action);
                     }
                     instance->lastMousePos = cursorPos;
                     break;
@@ -296,12 +361,12 @@ private:
                 case WM_MBUTTONDOWN:
                     action.type = ActionType::MOUSE_PRESS;
                     action.button = instance->getButtonName(static_cast<UINT>(wParam));
-                    { std::lock_guard<std::mutex> lk(instance->actionsMutex); instance->actions.push_back(action); }
+                    instance->capture(action);
                     break;
                 case WM_RBUTTONDOWN:
                     action.type = ActionType::MOUSE_PRESS;
                     action.button = "right";
-                    { std::lock_guard<std::mutex> lk(instance->actionsMutex); instance->actions.push_back(action); }
+                    instance->capture(action);
                     instance->isRightButtonPressed = true;
                     instance->lastMousePos = cursorPos;
                     break;
@@ -309,20 +374,20 @@ private:
                 case WM_MBUTTONUP:
                     action.type = ActionType::MOUSE_RELEASE;
                     action.button = instance->getButtonName(static_cast<UINT>(wParam));
-                    { std::lock_guard<std::mutex> lk(instance->actionsMutex); instance->actions.push_back(action); }
+                    instance->capture(action);
                     break;
                 case WM_RBUTTONUP:
                     instance->isRightButtonPressed = false;
                     { std::lock_guard<std::mutex> lk(instance->rawMutex); instance->rawQueue.clear(); }
                     action.type = ActionType::MOUSE_RELEASE;
                     action.button = "right";
-                    { std::lock_guard<std::mutex> lk(instance->actionsMutex); instance->actions.push_back(action); }
+                    instance->capture(action);
                     break;
                 case WM_MOUSEWHEEL:
                     action.type = ActionType::MOUSE_SCROLL;
                     action.scrollDx = 0;
                     action.scrollDy = GET_WHEEL_DELTA_WPARAM(mouseInfo->mouseData) / WHEEL_DELTA;
-                    { std::lock_guard<std::mutex> lk(instance->actionsMutex); instance->actions.push_back(action); }
+                    instance->capture(action);
                     break;
             }
         }
@@ -332,14 +397,15 @@ private:
     static LRESULT CALLBACK KeyboardHookProc(int nCode, WPARAM wParam, LPARAM lParam) {
         if (nCode >= 0 && instance) {
             KBDLLHOOKSTRUCT* keyInfo = reinterpret_cast<KBDLLHOOKSTRUCT*>(lParam);
-            
-            // Hotkeys
+            if (keyInfo->flags & LLKHF_INJECTED) instance->onInjectedArrival(ArrivalClass::KEY);
+
+            // Hotkeys: only post to the control thread, never block the hook
             if (wParam == WM_KEYDOWN) {
-                if (keyInfo->vkCode == VK_F1) { instance->toggleRecording(); return 1; }
-                if (keyInfo->vkCode == VK_F2) { instance->playLast(); return 1; }
-                if (keyInfo->vkCode == VK_F3) { instance->stopPlayback(); return 1; }
-                if (keyInfo->vkCode == VK_F4) { instance->toggleMode(); return 1; }
-                if (keyInfo->vkCode == VK_ESCAPE) { instance->emergencyStop(); return 1; }
+                if (keyInfo->vkCode == VK_F1) { instance->postCommand(RecorderCommand::TOGGLE_RECORDING); return 1; }
+                if (keyInfo->vkCode == VK_F2) { instance->postCommand(RecorderCommand::PLAY_LAST); return 1; }
+                if (keyInfo->vkCode == VK_F3) { instance->postCommand(RecorderCommand::STOP_PLAYBACK); return 1; }
+                if (keyInfo->vkCode == VK_F4) { instance->postCommand(RecorderCommand::TOGGLE_MODE); return 1; }
+                if (keyInfo->vkCode == VK_ESCAPE) { instance->requestEmergencyStop(); return 1; }
             }
             
             if (instance->recording) {
@@ -348,17 +414,16 @@ private:
                 if (!isRepeat) {
                     Action action;
                     action.time = instance->getCurrentTime();
+                    action.seq = instance->captureSeq++;
                     action.key = instance->getKeyName(keyInfo->vkCode);
                     action.vkCode = keyInfo->vkCode;
                     action.isRawDelta = false;
                     if (wParam == WM_KEYDOWN || wParam == WM_SYSKEYDOWN) {
                         action.type = ActionType::KEY_PRESS;
-                        std::lock_guard<std::mutex> lk(instance->actionsMutex);
-                        instance->actions.push_back(action);
+                        instance->capture(action);
                     } else if (wParam == WM_KEYUP || wParam == WM_SYSKEYUP) {
                         action.type = ActionType::KEY_RELEASE;
-                        std::lock_guard<std::mutex> lk(instance->actionsMutex);
-                        instance->actions.push_back(action);
+                        instance->capture(action);
                     }
                 }
             }
@@ -366,9 +431,187 @@ private:
         return CallNextHookEx(nullptr, nCode, wParam, lParam);
     }
 
+    void runCommand(RecorderCommand cmd) {
+        switch (cmd) {
+            case RecorderCommand::TOGGLE_RECORDING: toggleRecording(); break;
+            case RecorderCommand::PLAY_LAST:        playLast(); break;
+            case RecorderCommand::STOP_PLAYBACK:    stopPlayback(); break;
+            case RecorderCommand::TOGGLE_MODE:      toggleMode(); break;
+            case RecorderCommand::EMERGENCY_STOP:
+                emergencyRequested = false;
+                emergencyStop();
+                break;
+            case RecorderCommand::TAKE_LOADED: {
+                std::deque<LoadedTake> takes;
+                { std::lock_guard<std::mutex> lk(pendingMutex); takes.swap(loadedTakes); }
+                for (auto& t : takes) adoptTake(t);
+                notifyGUI(NOTIFY_STATUS);
+                break;
+            }
+            case RecorderCommand::EDIT_RECORDING: {
+                std::deque<PendingEdit> edits;
+                { std::lock_guard<std::mutex> lk(pendingMutex); edits.swap(pendingEdits); }
+                if (edits.empty()) break;
+                if (recording || playbackRunning) {
+                    // the take is changing under them; say so rather than drop them silently
+                    wchar_t text[128];
+                    swprintf_s(text, L"%zu edit(s) ignored: stop recording/playback first.", edits.size());
+                    setAnalyticsText(text);
+                    break;
+                }
+                for (const auto& e : edits) applyEdit(e);
+                break;
+            }
+        }
+    }
+
+    void jobLoop() {
+        for (;;) {
+            std::function<void()> job;
+            {
+                std::unique_lock<std::mutex> lk(jobMutex);
+                jobCv.wait(lk, [this]() { return !jobs.empty() || !jobsRunning; });
+                if (jobs.empty()) return;   // stopping, and queued saves are done
+                job = std::move(jobs.front());
+                jobs.pop_front();
+            }
+            try { job(); } catch (...) {}
+        }
+    }
+
+    // Safe from any thread except the LL hooks (allocates and locks).
+    void postJob(std::function<void()> job) {
+        {
+            std::lock_guard<std::mutex> lk(jobMutex);
+            if (!jobsRunning) return;
+            jobs.push_back(std::move(job));
+        }
+        jobCv.notify_one();
+    }
+
+    // Job thread: hands a parsed take to the control thread, which swaps it in.
+    void offerTake(std::vector<Action> events, const std::string& path, bool replaceTracks) {
+        LoadedTake t;
+        t.name = fs::path(path).stem().string();
+        if (replaceTracks) t.split = splitBySource(events);
+        t.source = std::make_shared<const EditSource>(std::move(events), t.name);
+        t.replaceTracks = replaceTracks;
+        { std::lock_guard<std::mutex> lk(pendingMutex); loadedTakes.push_back(std::move(t)); }
+        postCommand(RecorderCommand::TAKE_LOADED);
+    }
+
+    // Control thread: only swaps buffers and resets the piece list.
+    void adoptTake(LoadedTake& t) {
+        if (t.replaceTracks) {
+            // playback snapshots (or compiles edits into) the tracks during its pre-roll
+            if (recording || playbackRunning) {
+                setAnalyticsText(L"Take not loaded: stop recording/playback first.");
+                return;
+            }
+            tracks.assign(std::move(t.split));
+        }
+        editBaseName = t.name;
+        editor.reset(std::move(t.source));
+        editDirty = false;
+    }
+
+    void controlLoop() {
+        applyThreadPolicy(threadPolicy.control);
+        while (controlRunning) {
+            WaitForSingleObject(commandEvent, 100);
+            // a track that outgrew its reservation is re-locked at its new address
+            if (recording && threadPolicy.lockMemory) refreshCaptureLocks();
+            RecorderCommand cmd;
+            for (;;) {
+                if (emergencyRequested.exchange(false)) {
+                    // drop everything queued before ESC was pressed
+                    size_t cutoff = emergencyCutoff.load();
+                    while (commands.dequeuedCount() < cutoff && commands.pop(cmd)) {}
+                    emergencyStop();
+                    continue;
+                }
+                if (!commands.pop(cmd)) break;
+                runCommand(cmd);
+            }
+        }
+    }
+
 public:
     void setMainWindow(HWND hwnd) { mainWindow = hwnd; }
 
+    // Safe from any thread, including the LL hooks. Full queue drops the command.
+    void postCommand(RecorderCommand cmd) {
+        if (commands.push(cmd) && commandEvent) SetEvent(commandEvent);
+    }
+
+    // Takes effect immediately for capture and playback; the control thread
+    // finishes the teardown and discards any commands still queued.
+    void requestEmergencyStop() {
+        recording = false;
+        calibrating = false;
+        loopPlayback = false;
+        playbackRunning = false;
+        emergencyCutoff = commands.enqueuedCount();
+        emergencyRequested = true;
+        if (commandEvent) SetEvent(commandEvent);
+    }
+
+    void requestLoad(const std::string& path) {
+        postJob([this, path]() {
+            std::vector<Action> loaded;
+            if (readRecordingFile(path, loaded)) offerTake(std::move(loaded), path, true);
+        });
+    }
+
+    void requestAnalyze(const std::string& path) {
+        postJob([this, path]() { analyzeRecordingFile(path); });
+    }
+
+    void requestFindLoop(const std::string& path) {
+        postJob([this, path]() { if (!recording && !playbackRunning) findLoopInFile(path); });
+    }
+
+    void requestDiff(const std::string& path) {
+        postJob([this, path]() { if (!recording) diffAgainstFile(path); });
+    }
+
+    void requestTune(const std::string& path) {
+        postJob([this, path]() { if (!recording) tuneFromFile(path); });
+    }
+
+    void requestCalibration() {
+        postJob([this]() { calibrateInjection(); });
+    }
+
+    // Edits go through the job queue too, so one that needs a file parsed
+    // stays in order with the ones around it.
+    void requestEdit(EditOp op, double from, double to, double amount) {
+        std::string path;
+        if (op == EditOp::SPLICE || op == EditOp::APPEND) {
+            path = selectedRecordingPath();
+            if (path.empty()) return;
+        }
+        postJob([this, op, from, to, amount, path]() {
+            PendingEdit e{ op, from, to, amount, nullptr };
+            if (!path.empty()) {
+                std::vector<Action> other;
+                if (!readRecordingFile(path, other) || other.empty()) return;
+                e.insert = std::make_shared<const EditSource>(std::move(other), fs::path(path).stem().string());
+            }
+            { std::lock_guard<std::mutex> lk(pendingMutex); pendingEdits.push_back(std::move(e)); }
+            postCommand(RecorderCommand::EDIT_RECORDING);
+        });
+    }
+
+    std::wstring analyticsSummary() {
+        std::lock_guard<std::mutex> lk(analyticsMutex);
+        return analyticsText;
+    }
+
+    void notifyGUI(WPARAM what) {
+        if (mainWindow) PostMessageW(mainWindow, WM_RECORDER_NOTIFY, what, 0);
+    }
+
     // public setters for loop UI
     void setLoopEnabled(bool v) { loopEnabled = v; }
     void setLoopTimes(int n) { loopTimes = n; }
@@ -380,8 +623,7 @@ public:
         if (recording) {
             auto elapsed = std::chrono::steady_clock::now() - recordStartTime;
             auto secs = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / 1000.0;
-            size_t count = 0;
-            { std::lock_guard<std::mutex> lk(actionsMutex); count = actions.size(); }
+            size_t count = tracks.size();
             swprintf_s(status, L"🔴 RECORDING (%.1fs) | Actions: %zu | Mode: %s", 
                 secs, count, recordOnMoveAlways ? L"Roblox-compatible" : L"Original");
         } else if (playbackRunning) {
@@ -389,15 +631,14 @@ public:
                 if (loopTimes <= 0) {
                     swprintf_s(status, L"▶️ PLAYING | Loop: ∞ | Mode: %s", recordOnMoveAlways ? L"Roblox-compatible" : L"Original");
                 } else {
-                    swprintf_s(status, L"▶️ PLAYING | Loop x%d | Mode: %s", loopTimes, recordOnMoveAlways ? L"Roblox-compatible" : L"Original");
+                    swprintf_s(status, L"▶️ PLAYING | Loop x%d | Mode: %s", loopTimes.load(), recordOnMoveAlways ? L"Roblox-compatible" : L"Original");
                 }
             } else {
                 swprintf_s(status, L"▶️ PLAYING | Mode: %s", 
                     recordOnMoveAlways ? L"Roblox-compatible" : L"Original");
             }
         } else {
-            size_t count = 0;
-            { std::lock_guard<std::mutex> lk(actionsMutex); count = actions.size(); }
+            size_t count = tracks.size();
             swprintf_s(status, L"⏸️ IDLE | Actions: %zu | Mode: %s", 
                 count, recordOnMoveAlways ? L"Roblox-compatible" : L"Original");
         }
@@ -407,52 +648,100 @@ public:
     void toggleRecording() {
         if (!recording) startRecording();
         else stopRecording();
-        updateGUI();
+        notifyGUI(NOTIFY_STATUS);
     }
 
     void toggleMode() {
         recordOnMoveAlways = !recordOnMoveAlways;
-        updateGUI();
+        notifyGUI(NOTIFY_STATUS);
     }
 
     void startRecording() {
-        recording = true;
-        { std::lock_guard<std::mutex> lk(actionsMutex); actions.clear(); }
+        std::lock_guard<std::mutex> session(sessionMutex);
+        if (playbackRunning || calibrating) return;
+        stopRawProcessor();
+        releaseCaptureLocks();
+        tracks.clear();
+        tracks.prefault(threadPolicy.prefaultEvents);
+        if (threadPolicy.lockMemory) refreshCaptureLocks();
+        captureSeq = 0;
         startTime = std::chrono::steady_clock::now();
         recordStartTime = startTime;
         isRightButtonPressed = false;
         GetCursorPos(&lastMousePos);
+        recording = true;
         startRawProcessor();
-        updateGUI();
+        notifyGUI(NOTIFY_STATUS);
+    }
+
+    // Current (data, capacity bytes) of every track. Only the pointers are read
+    // under the track mutexes; faulting in and locking happens outside them, so
+    // the hooks never wait on it. A track that regrows in between is locked at
+    // its freed address (which fails or pins a few stray pages) and fixed on the
+    // next refresh.
+    std::array<std::pair<const void*, size_t>, EVENT_SOURCE_COUNT> captureBuffers() {
+        std::array<std::pair<const void*, size_t>, EVENT_SOURCE_COUNT> bufs{};
+        size_t slot = 0;
+        tracks.forEachBuffer([&bufs, &slot](const void* data, size_t bytes) { bufs[slot++] = { data, bytes }; });
+        return bufs;
+    }
+
+    // Locks track buffers that are new or moved since the last call.
+    void refreshCaptureLocks() {
+        auto bufs = captureBuffers();
+        for (size_t i = 0; i < bufs.size(); ++i) lockedTracks.refresh(i, bufs[i].first, bufs[i].second);
+    }
+
+    void releaseCaptureLocks() {
+        auto bufs = captureBuffers();
+        for (size_t i = 0; i < bufs.size(); ++i) lockedTracks.release(i, bufs[i].first, bufs[i].second);
     }
 
     void stopRecording() {
         recording = false;
         stopRawProcessor();
-        updateGUI();
-        if (!actions.empty()) {
-            fs::create_directories("recordings");
+        releaseCaptureLocks();
+        notifyGUI(NOTIFY_STATUS);
+        if (!tracks.empty()) {
             auto now = std::chrono::system_clock::now();
             auto time = std::chrono::system_clock::to_time_t(now);
             std::stringstream ss;
             ss << "recordings/recording_" << std::put_time(std::localtime(&time), "%Y%m%d_%H%M%S") << ".json";
-            saveRecording(ss.str());
-            refreshRecordingsList();
+            // the copy is cheap next to encoding; the job writes it and sends it back as the edit base
+            auto snap = std::make_shared<TrackSnapshot>(tracks.snapshot());
+            auto raw = std::make_shared<std::vector<RawDelta>>();
+            raw->swap(rawLog);
+            std::string path = ss.str();
+            postJob([this, snap, raw, path]() {
+                fs::create_directories("recordings");
+                saveRecording(path, *snap);
+                if (!raw->empty()) writeRawLog(path, *raw);
+                offerTake(mergeTimeline(*snap), path, false);
+                notifyGUI(NOTIFY_LIST);
+            });
         }
     }
 
     void playLast() {
-        std::lock_guard<std::mutex> lk(actionsMutex);
-        if (!actions.empty() && !playbackRunning) {
+        std::lock_guard<std::mutex> session(sessionMutex);
+        if (recording || calibrating) return;
+        if ((!tracks.empty() || editDirty) && !playbackRunning) {
+            // pending edits are materialized by the playback thread, not here
+            std::shared_ptr<const RecordingEditor> edit;
+            if (editDirty) {
+                edit = std::make_shared<const RecordingEditor>(editor);
+                editDirty = false;
+            }
             // start playback with current loop config
-            std::thread(&KeyboardMouseRecorder::playRecording, this, loopEnabled, loopTimes).detach();
+            playbackRunning = true;
+            std::thread(&KeyboardMouseRecorder::playRecording, this, loopEnabled.load(), loopTimes.load(), edit).detach();
         }
     }
 
     void stopPlayback() {
         loopPlayback = false;
         playbackRunning = false;
-        updateGUI();
+        notifyGUI(NOTIFY_STATUS);
     }
 
     void emergencyStop() {
@@ -460,221 +749,323 @@ public:
         loopPlayback = false;
         playbackRunning = false;
         stopRawProcessor();
-        updateGUI();
-    }
-
-    void saveRecording(const std::string& filename) {
-        try {
-            json j = json::array();
-            { std::lock_guard<std::mutex> lk(actionsMutex);
-                for (const auto& action : actions) {
-                    json actionJson;
-                    actionJson["time"] = action.time;
-                    switch (action.type) {
-                        case ActionType::MOUSE_MOVE:
-                            actionJson["type"] = "mouse_move";
-                            actionJson["x"] = action.x; actionJson["y"] = action.y;
-                            actionJson["deltaX"] = action.deltaX; actionJson["deltaY"] = action.deltaY;
-                            break;
-                        case ActionType::MOUSE_DELTA:
-                            actionJson["type"] = "mouse_delta";
-                            actionJson["deltaX"] = action.deltaX; actionJson["deltaY"] = action.deltaY;
-                            actionJson["isRaw"] = true;
-                            break;
-                        case ActionType::MOUSE_PRESS:
-                        case ActionType::MOUSE_RELEASE:
-                            actionJson["type"] = (action.type == ActionType::MOUSE_PRESS) ? "mouse_press" : "mouse_release";
-                            actionJson["x"] = action.x; actionJson["y"] = action.y;
-                            actionJson["button"] = action.button;
-                            break;
-                        case ActionType::MOUSE_SCROLL:
-                            actionJson["type"] = "mouse_scroll";
-                            actionJson["x"] = action.x; actionJson["y"] = action.y;
-                            actionJson["dx"] = action.scrollDx; actionJson["dy"] = action.scrollDy;
-                            break;
-                        case ActionType::KEY_PRESS:
-                        case ActionType::KEY_RELEASE:
-                            actionJson["type"] = (action.type == ActionType::KEY_PRESS) ? "key_press" : "key_release";
-                            actionJson["key"] = action.key;
-                            actionJson["vkCode"] = action.vkCode;
-                            break;
-                    }
-                    j.push_back(actionJson);
+        releaseCaptureLocks();
+        notifyGUI(NOTIFY_STATUS);
+    }
+
+    void saveRecording(const std::string& filename, const TrackSnapshot& snap) {
+        TimelineMerger merger;
+        merger.add(snap);
+        writeRecordingFile(filename, merger);
+    }
+
+    // Runs on the control thread. Only the piece list changes here.
+    void applyEdit(const PendingEdit& e) {
+        if (e.op == EditOp::SAVE) { saveEdit(); return; }
+        if (e.op == EditOp::SPLICE || e.op == EditOp::APPEND) {
+            if (editor.empty()) editBaseName = e.insert->name;
+            RecordingEditor insert(e.insert);
+            if (e.op == EditOp::SPLICE) editor.splice(e.from, insert);
+            else editor.concat(insert);
+        } else if (editor.empty()) {
+            setAnalyticsText(L"Load or record a take before editing.");
+            return;
+        } else if (e.op == EditOp::CUT) {
+            editor.cut(e.from, e.to);
+        } else if (e.op == EditOp::REPEAT) {
+            editor.repeatRange(e.from, e.to, static_cast<int>(e.amount));
+        } else if (e.op == EditOp::SHIFT) {
+            editor.timeShift(e.from, e.amount);
+        }
+        editDirty = true;
+        wchar_t text[256];
+        swprintf_s(text, L"Edit: %zu pieces, %.2fs | unsaved, applied on Play or Save Edit", editor.pieceCount(), editor.length());
+        setAnalyticsText(text);
+    }
+
+    // Writes the edited take as recordings/<base>_edit.json and loads it. The
+    // control thread only copies the piece list; the job materializes and writes.
+    void saveEdit() {
+        if (editor.empty()) {
+            setAnalyticsText(L"Nothing to save: load or record a take first.");
+            return;
+        }
+        auto edit = std::make_shared<const RecordingEditor>(editor);
+        std::string out = "recordings/" + editBaseName + "_edit.json";
+        postJob([this, edit, out]() {
+            std::vector<Action> edited = edit->materialize();
+            fs::create_directories("recordings");
+            TimelineMerger merger;
+            merger.add(edited);
+            if (!writeRecordingFile(out, merger)) return;
+            offerTake(std::move(edited), out, true);
+
+            wchar_t text[256];
+            swprintf_s(text, L"Saved edit as %hs", fs::path(out).filename().string().c_str());
+            setAnalyticsText(text);
+            notifyGUI(NOTIFY_LIST);
+        });
+    }
+
+    // Runs on the job thread; recording and playback can't start meanwhile.
+    // Probes every injection path (a cursor move to where it already is, +/-1 px
+    // deltas, right and middle clicks, F24) on a thread with the playback
+    // policy, timing each probe from its deadline to the hook. The clicks and
+    // F24 are real input to whatever is under the cursor or focused, so the GUI
+    // asks first. Anything a probe left down (ESC can stop between a press and
+    // its release) is released, and the cursor put back, before returning.
+    void calibrateInjection() {
+        {
+            std::lock_guard<std::mutex> session(sessionMutex);
+            if (recording || playbackRunning) return;
+            calibrating = true;
+        }
+        setAnalyticsText(L"Calibrating injection latency... (ESC aborts)");
+        LatencyProfile measured;
+        std::thread worker([&]() {
+            applyThreadPolicy(threadPolicy.playback);
+            std::unordered_set<WORD> keysDown;
+            std::unordered_set<std::string> buttonsDown;
+            double fracAccX = 0.0, fracAccY = 0.0;
+            POINT pos;
+            GetCursorPos(&pos);
+            double scale = std::max(1e-3, static_cast<double>(TUNING_SENSITIVITY * TUNING_PLAYBACK_VELOCITY));
+            measured = calibrateInjectionLatency([&](InjectKind kind, size_t i) {
+                bool press = (i % 2) == 0;
+                Action a;
+                a.x = pos.x; a.y = pos.y;
+                switch (kind) {
+                    case InjectKind::MOVE_ABSOLUTE: a.type = ActionType::MOUSE_MOVE; break;
+                    case InjectKind::MOVE_RELATIVE: a.type = ActionType::MOUSE_DELTA; a.deltaX = (press ? 1.0 : -1.0) / scale; break;
+                    case InjectKind::BUTTON_RIGHT:
+                    case InjectKind::BUTTON_CLICK:
+                        a.type = press ? ActionType::MOUSE_PRESS : ActionType::MOUSE_RELEASE;
+                        a.button = kind == InjectKind::BUTTON_RIGHT ? "right" : "middle";
+                        break;
+                    default:
+                        a.type = press ? ActionType::KEY_PRESS : ActionType::KEY_RELEASE;
+                        a.vkCode = VK_F24; a.key = "F24";
+                        break;
+                }
+                if (injectAction(a, keysDown, fracAccX, fracAccY)) {
+                    if (a.type == ActionType::MOUSE_PRESS) buttonsDown.insert(a.button);
+                    else if (a.type == ActionType::MOUSE_RELEASE) buttonsDown.erase(a.button);
                 }
+            }, latencySink, LATENCY_PROBES, std::chrono::milliseconds(LATENCY_PROBE_SPACING_MS), calibrating);
+
+            for (const auto& button : buttonsDown) {
+                Action up;
+                up.type = ActionType::MOUSE_RELEASE;
+                up.button = button;
+                up.x = pos.x; up.y = pos.y;
+                injectAction(up, keysDown, fracAccX, fracAccY);
+            }
+            std::vector<WORD> held(keysDown.begin(), keysDown.end());
+            for (WORD vk : held) {
+                Action up;
+                up.type = ActionType::KEY_RELEASE;
+                up.vkCode = vk;
+                injectAction(up, keysDown, fracAccX, fracAccY);
             }
-            std::ofstream file(filename);
-            file << j.dump(2);
-        } catch (...) {}
+            SetCursorPos(pos.x, pos.y);
+        });
+        worker.join();
+        if (!calibrating) {
+            setAnalyticsText(L"Calibration aborted; previous latency profile kept.");
+            return;
+        }
+        latencyProfile = measured;   // before calibrating drops, so playback never reads it mid-write
+        calibrating = false;
+        latencyProfile.save();
+
+        std::wstring text = L"Injection latency (median / p10-p90 spread, ms):";
+        for (size_t k = 0; k < INJECT_KIND_COUNT; ++k) {
+            wchar_t part[96];
+            const char* name = injectKindName(static_cast<InjectKind>(k));
+            if (measured.samples[k]) swprintf_s(part, L" %hs %.1f/%.1f", name, measured.latency[k] * 1e3, measured.jitter[k] * 1e3);
+            else swprintf_s(part, L" %hs n/a", name);
+            text += part;
+        }
+        text += L"\r\nPlayback now sends each event early by its path's latency.";
+        setAnalyticsText(text);
     }
 
-    bool loadRecording(const std::string& filename) {
-        try {
-            std::ifstream file(filename);
-            json j = json::parse(file);
-            { std::lock_guard<std::mutex> lk(actionsMutex);
-                actions.clear();
-                for (const auto& actionJson : j) {
-                    Action action;
-                    action.time = actionJson.at("time");
-                    std::string typeStr = actionJson.at("type");
-                    if (typeStr == "mouse_move") {
-                        action.type = ActionType::MOUSE_MOVE;
-                        action.x = actionJson.at("x"); action.y = actionJson.at("y");
-                        if (actionJson.contains("deltaX")) action.deltaX = actionJson.at("deltaX");
-                        if (actionJson.contains("deltaY")) action.deltaY = actionJson.at("deltaY");
-                    } else if (typeStr == "mouse_delta") {
-                        action.type = ActionType::MOUSE_DELTA;
-                        action.deltaX = actionJson.at("deltaX"); action.deltaY = actionJson.at("deltaY");
-                        action.isRawDelta = actionJson.value("isRaw", false);
-                    } else if (typeStr == "mouse_press") {
-                        action.type = ActionType::MOUSE_PRESS;
-                        action.x = actionJson.at("x"); action.y = actionJson.at("y");
-                        action.button = actionJson.at("button");
-                    } else if (typeStr == "mouse_release") {
-                        action.type = ActionType::MOUSE_RELEASE;
-                        action.x = actionJson.at("x"); action.y = actionJson.at("y");
-                        action.button = actionJson.at("button");
-                    } else if (typeStr == "mouse_scroll") {
-                        action.type = ActionType::MOUSE_SCROLL;
-                        action.x = actionJson.at("x"); action.y = actionJson.at("y");
-                        action.scrollDx = actionJson.at("dx"); action.scrollDy = actionJson.at("dy");
-                    } else if (typeStr == "key_press") {
-                        action.type = ActionType::KEY_PRESS;
-                        action.key = actionJson.at("key");
-                        action.vkCode = actionJson.value("vkCode", 0);
-                    } else if (typeStr == "key_release") {
-                        action.type = ActionType::KEY_RELEASE;
-                        action.key = actionJson.at("key");
-                        action.vkCode = actionJson.value("vkCode", 0);
+    // Error between when each injected event was meant to land and when the
+    // hooks saw it, after compensation.
+    void reportResidual() {
+        std::wstring text = L"Playback timing residual (mean / mean abs / max abs, ms):";
+        bool any = false;
+        for (size_t c = 0; c < ARRIVAL_CLASS_COUNT; ++c) {
+            ResidualTracker::Summary s = residuals.summary(static_cast<ArrivalClass>(c));
+            if (!s.samples) continue;
+            wchar_t part[128];
+            swprintf_s(part, L" %hs %+.1f / %.1f / %.1f (%zu)", arrivalClassName(static_cast<ArrivalClass>(c)),
+                s.mean * 1e3, s.meanAbs * 1e3, s.maxAbs * 1e3, s.samples);
+            text += part;
+            any = true;
+        }
+        if (!any) return;
+        text += latencyProfile.empty() ? L"\r\nNot compensated: run Calibrate." : L"\r\nCompensated with the calibrated latency profile.";
+        setAnalyticsText(text);
+    }
+
+    // Sends one recorded action. Returns true if input was actually injected
+    // (held-key filtering and sub-pixel accumulation can swallow an event).
+    bool injectAction(const Action& action, std::unordered_set<WORD>& keysDown, double& fracAccX, double& fracAccY) {
+        switch (action.type) {
+            case ActionType::MOUSE_MOVE: {
+                int screenWidth = GetSystemMetrics(SM_CXSCREEN);
+                int screenHeight = GetSystemMetrics(SM_CYSCREEN);
+                LONG normalizedX = static_cast<LONG>((action.x * 65535) / screenWidth);
+                LONG normalizedY = static_cast<LONG>((action.y * 65535) / screenHeight);
+                INPUT input = {0};
+                input.type = INPUT_MOUSE;
+                input.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
+                input.mi.dx = normalizedX; input.mi.dy = normalizedY;
+                SendInput(1, &input, sizeof(INPUT));
+                return true;
+            }
+            case ActionType::MOUSE_DELTA: {
+                double outDx = action.deltaX * TUNING_SENSITIVITY * TUNING_PLAYBACK_VELOCITY;
+                double outDy = action.deltaY * TUNING_SENSITIVITY * TUNING_PLAYBACK_VELOCITY;
+                double toSendX = outDx + fracAccX;
+                double toSendY = outDy + fracAccY;
+                int ix = static_cast<int>(std::round(toSendX));
+                int iy = static_cast<int>(std::round(toSendY));
+                fracAccX = toSendX - ix; fracAccY = toSendY - iy;
+                if (ix != 0 || iy != 0) {
+                    INPUT input = {0};
+                    input.type = INPUT_MOUSE; input.mi.dwFlags = MOUSEEVENTF_MOVE;
+                    input.mi.dx = ix; input.mi.dy = iy;
+                    SendInput(1, &input, sizeof(INPUT));
+                    return true;
+                }
+                return false;
+            }
+            case ActionType::MOUSE_PRESS:
+            case ActionType::MOUSE_RELEASE: {
+                if (action.button == "right") {
+                    DWORD flag = (action.type == ActionType::MOUSE_PRESS) ? MOUSEEVENTF_RIGHTDOWN : MOUSEEVENTF_RIGHTUP;
+                    mouse_event(flag, 0, 0, 0, 0);
+                    return true;
+                } else {
+                    int screenWidth = GetSystemMetrics(SM_CXSCREEN);
+                    int screenHeight = GetSystemMetrics(SM_CYSCREEN);
+                    LONG normalizedX = static_cast<LONG>((action.x * 65535) / screenWidth);
+                    LONG normalizedY = static_cast<LONG>((action.y * 65535) / screenHeight);
+                    INPUT moveInput = {0};
+                    moveInput.type = INPUT_MOUSE;
+                    moveInput.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
+                    moveInput.mi.dx = normalizedX; moveInput.mi.dy = normalizedY;
+                    SendInput(1, &moveInput, sizeof(INPUT));
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                    if (action.button == "left") {
+                        DWORD flag = (action.type == ActionType::MOUSE_PRESS) ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_LEFTUP;
+                        mouse_event(flag, 0, 0, 0, 0);
+                        return true;
+                    } else if (action.button == "middle") {
+                        DWORD flag = (action.type == ActionType::MOUSE_PRESS) ? MOUSEEVENTF_MIDDLEDOWN : MOUSEEVENTF_MIDDLEUP;
+                        mouse_event(flag, 0, 0, 0, 0);
+                        return true;
                     }
-                    actions.push_back(action);
                 }
+                return false;
+            }
+            case ActionType::MOUSE_SCROLL: {
+                INPUT input = {0};
+                input.type = INPUT_MOUSE; input.mi.dwFlags = MOUSEEVENTF_WHEEL;
+                input.mi.mouseData = action.scrollDy * WHEEL_DELTA;
+                SendInput(1, &input, sizeof(INPUT));
+                return true;
             }
-            return true;
-        } catch (...) { return false; }
+            case ActionType::KEY_PRESS:
+            case ActionType::KEY_RELEASE: {
+                WORD vk = (action.vkCode != 0) ? static_cast<WORD>(action.vkCode) : (VkKeyScanA(action.key[0]) & 0xFF);
+                if (vk == 0) return false;
+                UINT scancode = MapVirtualKeyA(vk, MAPVK_VK_TO_VSC);
+                if (action.type == ActionType::KEY_PRESS) {
+                    if (keysDown.find(vk) == keysDown.end()) {
+                        INPUT in = {0}; in.type = INPUT_KEYBOARD;
+                        in.ki.wScan = static_cast<WORD>(scancode);
+                        in.ki.dwFlags = KEYEVENTF_SCANCODE;
+                        SendInput(1, &in, sizeof(INPUT));
+                        keysDown.insert(vk);
+                        return true;
+                    }
+                } else {
+                    if (keysDown.find(vk) != keysDown.end()) {
+                        INPUT in = {0}; in.type = INPUT_KEYBOARD;
+                        in.ki.wScan = static_cast<WORD>(scancode);
+                        in.ki.dwFlags = KEYEVENTF_SCANCODE | KEYEVENTF_KEYUP;
+                        SendInput(1, &in, sizeof(INPUT));
+                        keysDown.erase(vk);
+                        return true;
+                    }
+                }
+                return false;
+            }
+        }
+        return false;
+
     }
 
-    // playRecording now supports loop flag + count (0 = infinite if loop==true)
-    void playRecording(bool loop, int loopCount) {
-        {
-            std::lock_guard<std::mutex> lk(actionsMutex);
-            if (actions.empty()) return;
+    // playRecording now supports loop flag + count (0 = infinite if loop==true).
+    // Pending edits arrive as a copy of the editor and are compiled into the
+    // playback tracks here, off the control thread.
+    void playRecording(bool loop, int loopCount, std::shared_ptr<const RecordingEditor> edit) {
+        if (edit) {
+            tracks.assign(edit->materialize());
+            notifyGUI(NOTIFY_STATUS);
         }
+        if (tracks.empty()) { playbackRunning = false; notifyGUI(NOTIFY_STATUS); return; }
+        applyThreadPolicy(threadPolicy.playback);
 
-        playbackRunning = true;
         loopPlayback = loop;
-        updateGUI();
+        notifyGUI(NOTIFY_STATUS);
 
         std::this_thread::sleep_for(std::chrono::seconds(2));
 
-        // local snapshot outside loop to avoid re-locking next iterations
-        std::vector<Action> localActions;
-        {
-            std::lock_guard<std::mutex> lk(actionsMutex);
-            localActions = actions;
-        }
+        // local snapshot outside loop to avoid re-locking next iterations;
+        // the merger streams it in time order and is rewound for each loop
+        TrackSnapshot localTracks = tracks.snapshot();
+        TimelineMerger merger;
+        merger.add(localTracks);
+        residuals.reset();
+        bool locked = threadPolicy.lockMemory;
+        if (locked) for (const auto& t : localTracks) lockBuffer(t.data(), t.size() * sizeof(Action));
 
         auto doPlayOnce = [&](void)->bool {
             auto playbackStart = std::chrono::steady_clock::now();
             std::unordered_set<WORD> keysDown;
             double fracAccX = 0.0, fracAccY = 0.0;
+            merger.reset();
 
-            for (size_t idx = 0; idx < localActions.size(); ++idx) {
+            while (const Action* next = merger.next()) {
                 if (!playbackRunning) break;
 
-                const Action &action = localActions[idx];
-                auto targetTime = playbackStart + std::chrono::milliseconds(static_cast<long long>(action.time * 1000.0 + 0.5));
+                const Action &action = *next;
+                // fire early by the calibrated latency of this injection path
+                InjectKind kind = injectKindOf(action);
+                auto intended = playbackStart + std::chrono::microseconds(std::llround(action.time * 1e6));
+                auto targetTime = intended - std::chrono::microseconds(std::llround(latencyProfile.lead(kind) * 1e6));
                 std::this_thread::sleep_until(targetTime);
 
+                // expectations go in first: the hooks can queue the arrival before SendInput returns
+                ArrivalClass cls = arrivalClassOf(kind);
+                if (kind == InjectKind::BUTTON_CLICK) residuals.expect(ArrivalClass::MOVE, intended, false);
+                residuals.expect(cls, intended);
+                bool sent = false;
                 try {
-                    switch (action.type) {
-                        case ActionType::MOUSE_MOVE: {
-                            int screenWidth = GetSystemMetrics(SM_CXSCREEN);
-                            int screenHeight = GetSystemMetrics(SM_CYSCREEN);
-                            LONG normalizedX = static_cast<LONG>((action.x * 65535) / screenWidth);
-                            LONG normalizedY = static_cast<LONG>((action.y * 65535) / screenHeight);
-                            INPUT input = {0};
-                            input.type = INPUT_MOUSE;
-                            input.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
-                            input.mi.dx = normalizedX; input.mi.dy = normalizedY;
-                            SendInput(1, &input, sizeof(INPUT));
-                            break;
-                        }
-                        case ActionType::MOUSE_DELTA: {
-                            double outDx = action.deltaX * TUNING_SENSITIVITY * TUNING_PLAYBACK_VELOCITY;
-                            double outDy = action.deltaY * TUNING_SENSITIVITY * TUNING_PLAYBACK_VELOCITY;
-                            double toSendX = outDx + fracAccX;
-                            double toSendY = outDy + fracAccY;
-                            int ix = static_cast<int>(std::round(toSendX));
-                            int iy = static_cast<int>(std::round(toSendY));
-                            fracAccX = toSendX - ix; fracAccY = toSendY - iy;
-                            if (ix != 0 || iy != 0) {
-                                INPUT input = {0};
-                                input.type = INPUT_MOUSE; input.mi.dwFlags = MOUSEEVENTF_MOVE;
-                                input.mi.dx = ix; input.mi.dy = iy;
-                                SendInput(1, &input, sizeof(INPUT));
-                            }
-                            break;
-                        }
-                        case ActionType::MOUSE_PRESS:
-                        case ActionType::MOUSE_RELEASE: {
-                            if (action.button == "right") {
-                                DWORD flag = (action.type == ActionType::MOUSE_PRESS) ? MOUSEEVENTF_RIGHTDOWN : MOUSEEVENTF_RIGHTUP;
-                                mouse_event(flag, 0, 0, 0, 0);
-                            } else {
-                                int screenWidth = GetSystemMetrics(SM_CXSCREEN);
-                                int screenHeight = GetSystemMetrics(SM_CYSCREEN);
-                                LONG normalizedX = static_cast<LONG>((action.x * 65535) / screenWidth);
-                                LONG normalizedY = static_cast<LONG>((action.y * 65535) / screenHeight);
-                                INPUT moveInput = {0};
-                                moveInput.type = INPUT_MOUSE;
-                                moveInput.mi.dwFlags = MOUSEEVENTF_MOVE | MOUSEEVENTF_ABSOLUTE;
-                                moveInput.mi.dx = normalizedX; moveInput.mi.dy = normalizedY;
-                                SendInput(1, &moveInput, sizeof(INPUT));
-                                std::this_thread::sleep_for(std::chrono::milliseconds(2));
-                                if (action.button == "left") {
-                                    DWORD flag = (action.type == ActionType::MOUSE_PRESS) ? MOUSEEVENTF_LEFTDOWN : MOUSEEVENTF_LEFTUP;
-                                    mouse_event(flag, 0, 0, 0, 0);
-                                } else if (action.button == "middle") {
-                                    DWORD flag = (action.type == ActionType::MOUSE_PRESS) ? MOUSEEVENTF_MIDDLEDOWN : MOUSEEVENTF_MIDDLEUP;
-                                    mouse_event(flag, 0, 0, 0, 0);
-                                }
-                            }
-                            break;
-                        }
-                        case ActionType::MOUSE_SCROLL: {
-                            INPUT input = {0};
-                            input.type = INPUT_MOUSE; input.mi.dwFlags = MOUSEEVENTF_WHEEL;
-                            input.mi.mouseData = action.scrollDy * WHEEL_DELTA;
-                            SendInput(1, &input, sizeof(INPUT));
-                            break;
-                        }
-                        case ActionType::KEY_PRESS:
-                        case ActionType::KEY_RELEASE: {
-                            WORD vk = (action.vkCode != 0) ? static_cast<WORD>(action.vkCode) : (VkKeyScanA(action.key[0]) & 0xFF);
-                            if (vk == 0) break;
-                            UINT scancode = MapVirtualKeyA(vk, MAPVK_VK_TO_VSC);
-                            if (action.type == ActionType::KEY_PRESS) {
-                                if (keysDown.find(vk) == keysDown.end()) {
-                                    INPUT in = {0}; in.type = INPUT_KEYBOARD;
-                                    in.ki.wScan = static_cast<WORD>(scancode);
-                                    in.ki.dwFlags = KEYEVENTF_SCANCODE;
-                                    SendInput(1, &in, sizeof(INPUT));
-                                    keysDown.insert(vk);
-                                }
-                            } else {
-                                if (keysDown.find(vk) != keysDown.end()) {
-                                    INPUT in = {0}; in.type = INPUT_KEYBOARD;
-                                    in.ki.wScan = static_cast<WORD>(scancode);
-                                    in.ki.dwFlags = KEYEVENTF_SCANCODE | KEYEVENTF_KEYUP;
-                                    SendInput(1, &in, sizeof(INPUT));
-                                    keysDown.erase(vk);
-                                }
-                            }
-                            break;
-                        }
-                    }
+                    sent = injectAction(action, keysDown, fracAccX, fracAccY);
                 } catch (...) {}
+                if (!sent) residuals.retract(cls);
+                residuals.match();
+
+                if (liveStream.isOpen()) {
+                    StreamEvent injected = toStreamEvent(action, STREAM_INJECTED);
+                    injected.time = std::chrono::duration<double>(std::chrono::steady_clock::now() - playbackStart).count();
+                    liveStream.ring().publish(injected);
+                }
             }
 
             for (WORD vk : keysDown) {
@@ -700,9 +1091,78 @@ public:
                 if (!doPlayOnce()) break;
             }
         }
+        if (locked) for (const auto& t : localTracks) unlockBuffer(t.data(), t.size() * sizeof(Action));
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));   // let the last arrivals reach the hooks
+        reportResidual();
 
         playbackRunning = false;
-        updateGUI();
+        notifyGUI(NOTIFY_STATUS);
+    }
+
+    // Owner-drawn preview of the selected recording: the cursor path on the left,
+    // X/Y envelopes over time with key activity underneath on the right. Both
+    // come from the pyramid, so drawing is O(pixels) for any recording length.
+    void drawPreview(const DRAWITEMSTRUCT* dis) {
+        HDC dc = dis->hDC;
+        RECT rc = dis->rcItem;
+        FillRect(dc, &rc, (HBRUSH)(COLOR_WINDOW + 1));
+        std::shared_ptr<TrajectoryPyramid> pyr;
+        { std::lock_guard<std::mutex> lk(analyticsMutex); pyr = previewPyramid; }
+        if (!pyr || pyr->empty() || pyr->length() <= 0.0) return;
+
+        const int h = rc.bottom - rc.top;
+        const int pathW = h;
+        const PyramidBucket& all = pyr->whole();
+        float spanX = std::max(1.0f, all.maxX - all.minX), spanY = std::max(1.0f, all.maxY - all.minY);
+
+        HPEN pathPen = CreatePen(PS_SOLID, 1, RGB(40, 40, 40));
+        HPEN xPen = CreatePen(PS_SOLID, 1, RGB(30, 90, 200));
+        HPEN yPen = CreatePen(PS_SOLID, 1, RGB(200, 60, 40));
+        HPEN keyPen = CreatePen(PS_SOLID, 1, RGB(150, 150, 150));
+        HGDIOBJ oldPen = SelectObject(dc, pathPen);
+
+        // trajectory, aspect-preserving
+        float scale = std::min((pathW - 8) / spanX, (h - 8) / spanY);
+        auto path = pyr->query(0.0, pyr->length(), static_cast<size_t>(pathW * 2));
+        std::vector<POINT> pts;
+        pts.reserve(path.size());
+        for (const auto& b : path) {
+            POINT p;
+            p.x = rc.left + 4 + static_cast<LONG>(((b.minX + b.maxX) * 0.5f - all.minX) * scale);
+            p.y = rc.top + 4 + static_cast<LONG>(((b.minY + b.maxY) * 0.5f - all.minY) * scale);
+            pts.push_back(p);
+        }
+        if (pts.size() > 1) Polyline(dc, pts.data(), static_cast<int>(pts.size()));
+
+        // timeline: one column per pixel
+        const int left = rc.left + pathW + 8;
+        const int width = rc.right - left;
+        const int keyBand = 10;
+        const int plotH = h - keyBand - 4;
+        if (width > 0) {
+            auto cols = pyr->query(0.0, pyr->length(), static_cast<size_t>(width));
+            auto yOf = [&](float v, float lo, float span) {
+                return rc.top + 2 + static_cast<int>((1.0f - (v - lo) / span) * (plotH - 1));
+            };
+            for (int c = 0; c < static_cast<int>(cols.size()); ++c) {
+                const PyramidBucket& b = cols[c];
+                SelectObject(dc, xPen);
+                MoveToEx(dc, left + c, yOf(b.maxX, all.minX, spanX), nullptr);
+                LineTo(dc, left + c, yOf(b.minX, all.minX, spanX) + 1);
+                SelectObject(dc, yPen);
+                MoveToEx(dc, left + c, yOf(b.maxY, all.minY, spanY), nullptr);
+                LineTo(dc, left + c, yOf(b.minY, all.minY, spanY) + 1);
+                if (b.presses || b.maxHeld) {
+                    SelectObject(dc, keyPen);
+                    int top = rc.bottom - 1 - std::min(keyBand, 3 + 2 * static_cast<int>(b.maxHeld));
+                    MoveToEx(dc, left + c, rc.bottom - 1, nullptr);
+                    LineTo(dc, left + c, top);
+                }
+            }
+        }
+
+        SelectObject(dc, oldPen);
+        DeleteObject(pathPen); DeleteObject(xPen); DeleteObject(yPen); DeleteObject(keyPen);
     }
 
     void refreshRecordingsList() {
@@ -715,7 +1175,9 @@ public:
             for (const auto& entry : fs::directory_iterator(folder)) {
                 if (entry.is_regular_file()) {
                     std::string filename = entry.path().filename().string();
-                    if (filename.find("recording_") == 0 && filename.find(".json") != std::string::npos) {
+                    // takes only: sidecars are named <take>.json.<kind>, so a second extension means not a take
+                    if (filename.find("recording_") == 0 && entry.path().extension() == ".json"
+                        && entry.path().stem().extension().empty()) {
                         std::wstring wname(filename.begin(), filename.end());
                         SendMessageW(hList, LB_ADDSTRING, 0, (LPARAM)wname.c_str());
                     }
@@ -724,23 +1186,196 @@ public:
         }
     }
 
-    void loadSelectedRecording() {
+    std::string selectedRecordingPath() {
         HWND hList = GetDlgItem(mainWindow, IDC_LIST_RECORDINGS);
         int sel = (int)SendMessageW(hList, LB_GETCURSEL, 0, 0);
-        if (sel != LB_ERR) {
-            wchar_t buf[256];
-            SendMessageW(hList, LB_GETTEXT, sel, (LPARAM)buf);
-            std::wstring wname(buf);
-            std::string filename(wname.begin(), wname.end());
-            std::string path = "recordings/" + filename;
-            if (loadRecording(path)) {
-                updateGUI();
+        if (sel == LB_ERR) return "";
+        wchar_t buf[256];
+        SendMessageW(hList, LB_GETTEXT, sel, (LPARAM)buf);
+        std::wstring wname(buf);
+        std::string filename(wname.begin(), wname.end());
+        return "recordings/" + filename;
+    }
+
+    void loadSelectedRecording() {
+        std::string path = selectedRecordingPath();
+        if (!path.empty()) requestLoad(path);
+    }
+
+    void analyzeSelectedRecording() {
+        std::string path = selectedRecordingPath();
+        if (!path.empty()) requestAnalyze(path);
+    }
+
+    void findLoopInSelectedRecording() {
+        std::string path = selectedRecordingPath();
+        if (!path.empty()) requestFindLoop(path);
+    }
+
+    void setAnalyticsText(const std::wstring& text) {
+        { std::lock_guard<std::mutex> lk(analyticsMutex); analyticsText = text; }
+        notifyGUI(NOTIFY_ANALYTICS);
+    }
+
+    // Runs on the job thread. The best cycle is saved as <name>_loop.json
+    // and loaded, ready to play with Loop enabled.
+    void findLoopInFile(const std::string& path) {
+        std::vector<Action> loaded;
+        if (!readRecordingFile(path, loaded)) return;
+        LoopCandidate c = detectLoop(loaded);
+        if (!c.found) {
+            setAnalyticsText(L"No repeating cycle found (need at least two cycles of 1s or longer).");
+            return;
+        }
+        std::vector<Action> cycle = extractLoop(loaded, c);
+        fs::path src(path);
+        std::string out = (src.parent_path() / (src.stem().string() + "_loop.json")).string();
+        TimelineMerger merger;
+        merger.add(cycle);
+        if (!writeRecordingFile(out, merger)) return;
+        offerTake(std::move(cycle), out, true);
+
+        wchar_t text[512];
+        swprintf_s(text, L"Loop: period %.2fs at %.2fs (correlation %.2f) | net drift %.0f, %.0f px | %zu held at cut\r\n"
+                         L"Saved and loaded as %hs",
+            c.period, c.start, c.correlation, c.netDx, c.netDy, c.heldAtCut, fs::path(out).filename().string().c_str());
+        setAnalyticsText(text);
+        notifyGUI(NOTIFY_LIST | NOTIFY_STATUS);
+    }
+
+    void diffSelectedRecording() {
+        std::string path = selectedRecordingPath();
+        if (!path.empty()) requestDiff(path);
+    }
+
+    // Runs on the job thread. The selected file is the reference, the loaded
+    // (or last recorded) take is compared against it. The full report goes to
+    // <reference>.diff.txt.
+    void diffAgainstFile(const std::string& path) {
+        std::vector<Action> reference;
+        if (!readRecordingFile(path, reference)) return;
+        std::vector<Action> take = mergeTimeline(tracks.snapshot());
+        if (take.empty()) {
+            setAnalyticsText(L"Nothing loaded to compare against the selected recording.");
+            return;
+        }
+        DiffReport r = diffRecordings(reference, take);
+        std::string out = path + ".diff.txt";
+        { std::ofstream f(out); f << formatDiffReport(r); }
+
+        wchar_t text[512];
+        if (!r.valid) {
+            swprintf_s(text, L"Diff: recordings could not be aligned (drift over %.0fs?)", DIFF_BAND_SEC);
+        } else {
+            swprintf_s(text, L"Diff: %zu divergent segments | offset final %.2fs, max %.2fs | path error final %.0f px, max %.0f px\r\n"
+                             L"Report: %hs",
+                r.segments.size(), r.finalOffset, r.maxOffset, r.finalDisplacement, r.maxDisplacement,
+                fs::path(out).filename().string().c_str());
+        }
+        setAnalyticsText(text);
+    }
+
+    void tuneSelectedRecording() {
+        std::string path = selectedRecordingPath();
+        if (!path.empty()) requestTune(path);
+    }
+
+    // Runs on the job thread. Replays the recording's raw-delta log through
+    // the smoother for a grid plus a random sample of settings, on all cores, and
+    // writes the Pareto-best ones to <recording>.tuning.txt (JSON). Nothing is applied.
+    void tuneFromFile(const std::string& path) {
+        std::vector<RawDelta> raw;
+        if (!readRawLog(path, raw) || raw.empty()) {
+            setAnalyticsText(L"Auto-tune needs the raw-delta log that is saved with new recordings (.raw).");
+            return;
+        }
+        setAnalyticsText(L"Auto-tune running...");
+        SmootherParams base = currentSmootherParams();
+        base.sensX = base.sensY = 1.0;
+        std::vector<SmootherParams> sets = gridCandidates(base);
+        std::vector<SmootherParams> sampled = randomCandidates(base, 512, 0x5eed);
+        sets.insert(sets.end(), sampled.begin(), sampled.end());
+        sets.push_back(base);
+
+        std::vector<TuneCandidate> all = sweepParameters(raw, sets);
+        std::vector<TuneCandidate> front = paretoFront(all);
+        const TuneCandidate& current = all.back();
+
+        json out;
+        out["candidates"] = all.size();
+        out["current"] = candidateToJson(current);
+        out["pareto"] = json::array();
+        for (const auto& c : front) out["pareto"].push_back(candidateToJson(c));
+        std::string outPath = path + ".tuning.txt";
+        { std::ofstream f(outPath); f << out.dump(2); }
+
+        wchar_t text[512];
+        if (front.empty()) {
+            swprintf_s(text, L"Auto-tune: no candidates scored.");
+        } else {
+            const TuneCandidate& b = front.front();
+            swprintf_s(text, L"Auto-tune (%zu sets, %zu Pareto): alpha %.2f thr %d frames %d ramp %dms decay %.2f"
+                             L" -> err %.0f px, overshoot %.0f px, %zu events\r\n"
+                             L"Current: err %.0f px, overshoot %.0f px, %zu events | %hs",
+                all.size(), front.size(), b.params.alpha, b.params.stopThreshold, b.params.stopFrames,
+                b.params.rampMs, b.params.rampDecay, b.displacementError, b.overshoot, b.eventCount,
+                current.displacementError, current.overshoot, current.eventCount,
+                fs::path(outPath).filename().string().c_str());
+        }
+        setAnalyticsText(text);
+    }
+
+    // Runs on the job thread. Stats and the preview pyramid are cached next
+    // to the recording; the JSON is parsed only if one of them is missing.
+    void analyzeRecordingFile(const std::string& path) {
+        std::vector<Action> loaded;
+        bool parsed = false;
+        auto events = [&]() -> const std::vector<Action>* {
+            if (!parsed) { parsed = true; if (!readRecordingFile(path, loaded)) loaded.clear(); }
+            return loaded.empty() ? nullptr : &loaded;
+        };
+
+        auto pyramid = std::make_shared<TrajectoryPyramid>();
+        if (!pyramid->load(path)) {
+            if (const auto* ev = events()) {
+                *pyramid = TrajectoryPyramid::build(*ev);
+                pyramid->save(path);
             }
         }
+        { std::lock_guard<std::mutex> lk(analyticsMutex); previewPyramid = pyramid->empty() ? nullptr : pyramid; }
+        notifyGUI(NOTIFY_PREVIEW);
+
+        RecordingStats st;
+        if (!loadCachedStats(path, st)) {
+            const auto* ev = events();
+            if (!ev) return;
+            st = analyzeRecording(ColumnarRecording::fromActions(*ev));
+            storeCachedStats(path, st);
+        }
+        size_t peakBin = std::max_element(st.velocityHist.begin(), st.velocityHist.end()) - st.velocityHist.begin();
+        wchar_t text[512];
+        swprintf_s(text, L"%zu events, %.1fs | Travel %.0f px (peak step %.0f, peak %.0f px/s, typical %zu-%zu px/s)\r\n"
+                         L"%.1f inputs/min | Key holds %zu (avg %.2fs, max %.2fs) | Idle %zu x (%.1fs total, longest %.1fs)",
+            st.eventCount, st.duration, st.totalTravel, st.peakStep, st.peakSpeed,
+            (size_t)(peakBin * ANALYTICS_VEL_BIN), (size_t)((peakBin + 1) * ANALYTICS_VEL_BIN),
+            st.inputsPerMinute, st.keyHolds, st.keyHoldMean, st.keyHoldMax,
+            st.idlePeriods, st.idleTotal, st.idleLongest);
+        setAnalyticsText(text);
     }
 
+    // Called on the GUI thread, which also runs the LL hooks and WM_INPUT: that
+    // is the capture thread.
     void startListeners() {
         instance = this;
+        threadPolicy = loadThreadPolicyConfig();
+        latencyProfile.load();
+        applyThreadPolicy(threadPolicy.capture);
+        liveStream.create(LIVE_STREAM_NAME);
+        commandEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        controlRunning = true;
+        controlThread = std::thread(&KeyboardMouseRecorder::controlLoop, this);
+        { std::lock_guard<std::mutex> lk(jobMutex); jobsRunning = true; }
+        jobThread = std::thread(&KeyboardMouseRecorder::jobLoop, this);
         createRawInputWindow();
         mouseHook = SetWindowsHookExW(WH_MOUSE_LL, MouseHookProc, nullptr, 0);
         keyboardHook = SetWindowsHookExW(WH_KEYBOARD_LL, KeyboardHookProc, nullptr, 0);
@@ -750,6 +1385,17 @@ public:
         if (mouseHook) UnhookWindowsHookEx(mouseHook);
         if (keyboardHook) UnhookWindowsHookEx(keyboardHook);
         if (hiddenWindow) DestroyWindow(hiddenWindow);
+        mainWindow = nullptr;
+        playbackRunning = false;
+        controlRunning = false;
+        if (commandEvent) SetEvent(commandEvent);
+        calibrating = false;
+        if (controlThread.joinable()) controlThread.join();
+        // after the control thread, so a save it queued on stop still runs
+        { std::lock_guard<std::mutex> lk(jobMutex); jobsRunning = false; }
+        jobCv.notify_one();
+        if (jobThread.joinable()) jobThread.join();
+        if (commandEvent) { CloseHandle(commandEvent); commandEvent = nullptr; }
         stopRawProcessor();
     }
 };
@@ -787,6 +1433,14 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                 20, 165, 450, 200, hwnd, (HMENU)IDC_LIST_RECORDINGS, nullptr, nullptr);
             CreateWindowW(L"BUTTON", L"Load & Play", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
                 480, 165, 100, 30, hwnd, (HMENU)IDC_BTN_LOAD, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"🔁 Find Loop", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                480, 205, 100, 30, hwnd, (HMENU)IDC_BTN_FIND_LOOP, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"Diff vs Loaded", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                480, 245, 100, 30, hwnd, (HMENU)IDC_BTN_DIFF, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"Auto-tune", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                480, 285, 100, 30, hwnd, (HMENU)IDC_BTN_TUNE, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"Calibrate", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                480, 325, 100, 30, hwnd, (HMENU)IDC_BTN_CALIBRATE, nullptr, nullptr);
 
             // Settings
             CreateWindowW(L"STATIC", L"Sensitivity:", WS_VISIBLE | WS_CHILD,
@@ -810,6 +1464,38 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             CreateWindowW(L"EDIT", L"1", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_LEFT,
                 210, 420, 80, 22, hwnd, (HMENU)IDC_EDIT_LOOP_COUNT, nullptr, nullptr);
 
+            // Analytics for the selected recording
+            CreateWindowW(L"STATIC", L"Select a recording to see its statistics.", WS_VISIBLE | WS_CHILD | SS_LEFT,
+                20, 455, 560, 40, hwnd, (HMENU)IDC_STATIC_ANALYTICS, nullptr, nullptr);
+            CreateWindowW(L"STATIC", nullptr, WS_VISIBLE | WS_CHILD | SS_OWNERDRAW,
+                20, 500, 560, 110, hwnd, (HMENU)IDC_PREVIEW, nullptr, nullptr);
+
+            // Editing of the loaded take (seconds)
+            CreateWindowW(L"STATIC", L"Edit from:", WS_VISIBLE | WS_CHILD,
+                20, 623, 65, 20, hwnd, nullptr, nullptr, nullptr);
+            CreateWindowW(L"EDIT", L"0", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_LEFT,
+                90, 620, 55, 22, hwnd, (HMENU)IDC_EDIT_FROM, nullptr, nullptr);
+            CreateWindowW(L"STATIC", L"to:", WS_VISIBLE | WS_CHILD,
+                155, 623, 25, 20, hwnd, nullptr, nullptr, nullptr);
+            CreateWindowW(L"EDIT", L"0", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_LEFT,
+                180, 620, 55, 22, hwnd, (HMENU)IDC_EDIT_TO, nullptr, nullptr);
+            CreateWindowW(L"STATIC", L"Times / shift (s):", WS_VISIBLE | WS_CHILD,
+                250, 623, 110, 20, hwnd, nullptr, nullptr, nullptr);
+            CreateWindowW(L"EDIT", L"2", WS_VISIBLE | WS_CHILD | WS_BORDER | ES_LEFT,
+                365, 620, 55, 22, hwnd, (HMENU)IDC_EDIT_AMOUNT, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"Cut", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                20, 650, 88, 28, hwnd, (HMENU)IDC_BTN_CUT, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"Repeat", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                114, 650, 88, 28, hwnd, (HMENU)IDC_BTN_REPEAT, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"Shift", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                208, 650, 88, 28, hwnd, (HMENU)IDC_BTN_SHIFT, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"Splice Sel.", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                302, 650, 88, 28, hwnd, (HMENU)IDC_BTN_SPLICE, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"Append Sel.", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                396, 650, 88, 28, hwnd, (HMENU)IDC_BTN_APPEND, nullptr, nullptr);
+            CreateWindowW(L"BUTTON", L"Save Edit", WS_VISIBLE | WS_CHILD | BS_PUSHBUTTON,
+                490, 650, 90, 28, hwnd, (HMENU)IDC_BTN_SAVE_EDIT, nullptr, nullptr);
+
             // Timer for updates
             SetTimer(hwnd, IDC_TIMER_UPDATE, 100, nullptr);
             
@@ -823,11 +1509,27 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
             }
             return 0;
 
+        case WM_DRAWITEM:
+            if (wParam == IDC_PREVIEW && recorder) {
+                recorder->drawPreview(reinterpret_cast<const DRAWITEMSTRUCT*>(lParam));
+                return TRUE;
+            }
+            break;
+
+        case WM_RECORDER_NOTIFY:
+            if (recorder) {
+                if (wParam & NOTIFY_LIST) recorder->refreshRecordingsList();
+                if (wParam & NOTIFY_ANALYTICS) SetDlgItemTextW(hwnd, IDC_STATIC_ANALYTICS, recorder->analyticsSummary().c_str());
+                if (wParam & NOTIFY_PREVIEW) InvalidateRect(GetDlgItem(hwnd, IDC_PREVIEW), nullptr, TRUE);
+                recorder->updateGUI();
+            }
+            return 0;
+
         case WM_COMMAND: {
             int wmId = LOWORD(wParam);
             switch (wmId) {
                 case IDC_BTN_RECORD:
-                    if (recorder) recorder->toggleRecording();
+                    if (recorder) recorder->postCommand(RecorderCommand::TOGGLE_RECORDING);
                     break;
                 case IDC_BTN_PLAY:
                     if (recorder) {
@@ -838,14 +1540,14 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                         GetDlgItemTextW(hwnd, IDC_EDIT_LOOP_COUNT, buf, 32);
                         int cnt = _wtoi(buf);
                         recorder->setLoopTimes(cnt);
-                        recorder->playLast();
+                        recorder->postCommand(RecorderCommand::PLAY_LAST);
                     }
                     break;
                 case IDC_BTN_STOP:
-                    if (recorder) recorder->stopPlayback();
+                    if (recorder) recorder->postCommand(RecorderCommand::STOP_PLAYBACK);
                     break;
                 case IDC_BTN_TOGGLE_MODE:
-                    if (recorder) recorder->toggleMode();
+                    if (recorder) recorder->postCommand(RecorderCommand::TOGGLE_MODE);
                     break;
                 case IDC_BTN_LOAD:
                     if (recorder) {
@@ -853,9 +1555,52 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
                         // optionally auto-play when loading? current behavior just loads; user can press Play
                     }
                     break;
+                case IDC_BTN_FIND_LOOP:
+                    if (recorder) recorder->findLoopInSelectedRecording();
+                    break;
+                case IDC_BTN_DIFF:
+                    if (recorder) recorder->diffSelectedRecording();
+                    break;
+                case IDC_BTN_TUNE:
+                    if (recorder) recorder->tuneSelectedRecording();
+                    break;
+                case IDC_BTN_CALIBRATE:
+                    if (recorder) {
+                        wchar_t warn[512];
+                        swprintf_s(warn, L"Calibration sends %zu right clicks, %zu middle clicks and %zu F24 presses as real input "
+                                         L"to the window under the cursor and the focused window.\n\n"
+                                         L"Keep the cursor over this window or an empty area until it finishes. ESC aborts.",
+                            LATENCY_PROBES / 2, LATENCY_PROBES / 2, LATENCY_PROBES / 2);
+                        if (MessageBoxW(hwnd, warn, L"Calibrate injection latency", MB_OKCANCEL | MB_ICONWARNING) == IDOK) {
+                            recorder->requestCalibration();
+                        }
+                    }
+                    break;
+                case IDC_BTN_CUT:
+                case IDC_BTN_REPEAT:
+                case IDC_BTN_SHIFT:
+                case IDC_BTN_SPLICE:
+                case IDC_BTN_APPEND:
+                case IDC_BTN_SAVE_EDIT:
+                    if (recorder) {
+                        wchar_t buf[32];
+                        GetDlgItemTextW(hwnd, IDC_EDIT_FROM, buf, 32);
+                        double from = _wtof(buf);
+                        GetDlgItemTextW(hwnd, IDC_EDIT_TO, buf, 32);
+                        double to = _wtof(buf);
+                        GetDlgItemTextW(hwnd, IDC_EDIT_AMOUNT, buf, 32);
+                        double amount = _wtof(buf);
+                        EditOp op = wmId == IDC_BTN_CUT ? EditOp::CUT : wmId == IDC_BTN_REPEAT ? EditOp::REPEAT
+                                  : wmId == IDC_BTN_SHIFT ? EditOp::SHIFT : wmId == IDC_BTN_SPLICE ? EditOp::SPLICE
+                                  : wmId == IDC_BTN_APPEND ? EditOp::APPEND : EditOp::SAVE;
+                        recorder->requestEdit(op, from, to, amount);
+                    }
+                    break;
                 case IDC_LIST_RECORDINGS:
                     if (HIWORD(wParam) == LBN_DBLCLK && recorder) {
                         recorder->loadSelectedRecording();
+                    } else if (HIWORD(wParam) == LBN_SELCHANGE && recorder) {
+                        recorder->analyzeSelectedRecording();
                     }
                     break;
                 case IDC_BTN_SAVE_SETTINGS: {
@@ -896,7 +1641,7 @@ int WINAPI wWinMain(HINSTANCE hInstance, HINSTANCE, PWSTR, int nCmdShow) {
     HWND hwnd = CreateWindowExW(0, L"RecorderMainClass",
         L"Keyboard & Mouse Recorder - GUI Edition",
         WS_OVERLAPPEDWINDOW & ~WS_MAXIMIZEBOX,
-        CW_USEDEFAULT, CW_USEDEFAULT, 620, 480,
+        CW_USEDEFAULT, CW_USEDEFAULT, 620, 725,
         nullptr, nullptr, hInstance, &recorder);
 
     if (!hwnd) return 0;
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+enum class ActionType {
+    MOUSE_MOVE, MOUSE_DELTA, MOUSE_PRESS, MOUSE_RELEASE, MOUSE_SCROLL,
+    KEY_PRESS, KEY_RELEASE
+};
+
+struct Action {
+    ActionType type;
+    int x = 0, y = 0;
+    double deltaX = 0.0, deltaY = 0.0;
+    std::string button;
+    std::string key;
+    uint32_t vkCode = 0;
+    int scrollDx = 0, scrollDy = 0;
+    double time = 0.0;
+    bool isRawDelta = false;
+    uint64_t seq = 0;   // capture order, breaks ties between equal timestamps
+};
+
+struct RawDelta {
+    int dx, dy;
+    double time;
+    uint64_t seq;
+};
@@ -0,0 +1,328 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "recording.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RECORDER_SIMD_SSE2 1
+#endif
+
+// Columnar view of a recording. Built once, then every kernel walks flat arrays
+// instead of std::vector<Action> with its strings.
+struct ColumnarRecording {
+    // all events
+    std::vector<double> time;
+    std::vector<uint8_t> type;
+    std::vector<uint32_t> vk;       // key identity, see keyId()
+    // motion events only (MOUSE_MOVE and MOUSE_DELTA)
+    std::vector<double> moveTime, moveDx, moveDy;
+
+    static ColumnarRecording fromActions(const std::vector<Action>& actions) {
+        ColumnarRecording c;
+        c.time.reserve(actions.size());
+        c.type.reserve(actions.size());
+        c.vk.reserve(actions.size());
+        for (const auto& a : actions) {
+            c.time.push_back(a.time);
+            c.type.push_back(static_cast<uint8_t>(a.type));
+            c.vk.push_back(keyId(a));
+            if (a.type == ActionType::MOUSE_MOVE || a.type == ActionType::MOUSE_DELTA) {
+                c.moveTime.push_back(a.time);
+                c.moveDx.push_back(a.deltaX);
+                c.moveDy.push_back(a.deltaY);
+            }
+        }
+        return c;
+    }
+
+    // vkCode, or for legacy files that recorded vk 0 an id derived from the key
+    // name (high bit set, so it can't collide with a real virtual-key code).
+    static uint32_t keyId(const Action& a) {
+        if (a.vkCode != 0 || a.key.empty()) return a.vkCode;
+        return 0x80000000u | (static_cast<uint32_t>(std::hash<std::string>{}(a.key)) & 0x7fffffffu);
+    }
+};
+
+static const int    ANALYTICS_HIST_BINS      = 16;
+static const double ANALYTICS_VEL_BIN        = 250.0;    // px/s per velocity bin
+static const double ANALYTICS_ACC_BIN        = 5000.0;   // px/s^2 per acceleration bin
+static const double ANALYTICS_MIN_DT         = 0.001;    // timestamps are ms-granular
+static const double ANALYTICS_IDLE_THRESHOLD = 1.0;      // seconds without any event
+
+struct RecordingStats {
+    size_t eventCount = 0;
+    double duration = 0.0;
+    double totalTravel = 0.0;       // px
+    double peakStep = 0.0;          // largest single motion event, px
+    double peakSpeed = 0.0;         // px/s
+    std::array<uint64_t, ANALYTICS_HIST_BINS> velocityHist{};
+    std::array<uint64_t, ANALYTICS_HIST_BINS> accelHist{};
+    size_t discreteInputs = 0;      // key/button presses and scroll events (one per wheel message)
+    double inputsPerMinute = 0.0;
+    size_t keyHolds = 0;
+    double keyHoldMean = 0.0, keyHoldMax = 0.0;
+    size_t idlePeriods = 0;
+    double idleTotal = 0.0, idleLongest = 0.0;
+};
+
+namespace analytics_detail {
+
+struct Partial {
+    double travel = 0.0, peakStep = 0.0, peakSpeed = 0.0;
+    std::array<uint64_t, ANALYTICS_HIST_BINS> vel{}, acc{};
+    size_t idleCount = 0;
+    double idleTotal = 0.0, idleLongest = 0.0;
+};
+
+inline int binOf(double v, double width) {
+    int b = static_cast<int>(v / width);
+    return b < 0 ? 0 : (b >= ANALYTICS_HIST_BINS ? ANALYTICS_HIST_BINS - 1 : b);
+}
+
+// speed[i] = |d_i| / max(t_i - t_{i-1}, MIN_DT); step lengths are summed into p.
+inline void speedKernel(const double* t, const double* dx, const double* dy, double* speed,
+                        size_t begin, size_t end, Partial& p) {
+    size_t i = begin;
+    if (i == 0 && i < end) {
+        double step = std::sqrt(dx[0] * dx[0] + dy[0] * dy[0]);
+        speed[0] = 0.0;   // no previous sample to time it against
+        p.travel += step;
+        p.peakStep = std::max(p.peakStep, step);
+        i = 1;
+    }
+#ifdef RECORDER_SIMD_SSE2
+    __m128d sum = _mm_setzero_pd(), maxStep = _mm_setzero_pd();
+    const __m128d minDt = _mm_set1_pd(ANALYTICS_MIN_DT);
+    for (; i + 2 <= end; i += 2) {
+        __m128d x = _mm_loadu_pd(dx + i), y = _mm_loadu_pd(dy + i);
+        __m128d step = _mm_sqrt_pd(_mm_add_pd(_mm_mul_pd(x, x), _mm_mul_pd(y, y)));
+        __m128d dt = _mm_max_pd(_mm_sub_pd(_mm_loadu_pd(t + i), _mm_loadu_pd(t + i - 1)), minDt);
+        _mm_storeu_pd(speed + i, _mm_div_pd(step, dt));
+        sum = _mm_add_pd(sum, step);
+        maxStep = _mm_max_pd(maxStep, step);
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, sum);
+    p.travel += lanes[0] + lanes[1];
+    _mm_storeu_pd(lanes, maxStep);
+    p.peakStep = std::max(p.peakStep, std::max(lanes[0], lanes[1]));
+#endif
+    for (; i < end; ++i) {
+        double step = std::sqrt(dx[i] * dx[i] + dy[i] * dy[i]);
+        speed[i] = step / std::max(t[i] - t[i - 1], ANALYTICS_MIN_DT);
+        p.travel += step;
+        p.peakStep = std::max(p.peakStep, step);
+    }
+}
+
+// Velocity/acceleration histograms over a precomputed speed column.
+inline void histogramKernel(const double* t, const double* speed, size_t begin, size_t end, Partial& p) {
+    size_t i = begin;
+    if (i == 0 && i < end) {
+        p.peakSpeed = std::max(p.peakSpeed, speed[0]);
+        p.vel[binOf(speed[0], ANALYTICS_VEL_BIN)]++;
+        i = 1;
+    }
+#ifdef RECORDER_SIMD_SSE2
+    const __m128d invVel = _mm_set1_pd(1.0 / ANALYTICS_VEL_BIN);
+    const __m128d invAcc = _mm_set1_pd(1.0 / ANALYTICS_ACC_BIN);
+    const __m128d minDt = _mm_set1_pd(ANALYTICS_MIN_DT);
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    const __m128d top = _mm_set1_pd(ANALYTICS_HIST_BINS - 1);
+    __m128d peak = _mm_setzero_pd();
+    for (; i + 2 <= end; i += 2) {
+        __m128d s = _mm_loadu_pd(speed + i);
+        __m128d dt = _mm_max_pd(_mm_sub_pd(_mm_loadu_pd(t + i), _mm_loadu_pd(t + i - 1)), minDt);
+        __m128d acc = _mm_andnot_pd(signMask, _mm_div_pd(_mm_sub_pd(s, _mm_loadu_pd(speed + i - 1)), dt));
+        peak = _mm_max_pd(peak, s);
+        __m128i vb = _mm_cvttpd_epi32(_mm_min_pd(_mm_mul_pd(s, invVel), top));
+        __m128i ab = _mm_cvttpd_epi32(_mm_min_pd(_mm_mul_pd(acc, invAcc), top));
+        int v[4], a[4];
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(v), vb);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(a), ab);
+        p.vel[v[0]]++; p.vel[v[1]]++;
+        p.acc[a[0]]++; p.acc[a[1]]++;
+    }
+    double lanes[2];
+    _mm_storeu_pd(lanes, peak);
+    p.peakSpeed = std::max(p.peakSpeed, std::max(lanes[0], lanes[1]));
+#endif
+    for (; i < end; ++i) {
+        double dt = std::max(t[i] - t[i - 1], ANALYTICS_MIN_DT);
+        double acc = std::fabs(speed[i] - speed[i - 1]) / dt;
+        p.peakSpeed = std::max(p.peakSpeed, speed[i]);
+        p.vel[binOf(speed[i], ANALYTICS_VEL_BIN)]++;
+        p.acc[binOf(acc, ANALYTICS_ACC_BIN)]++;
+    }
+}
+
+// Gaps of at least ANALYTICS_IDLE_THRESHOLD between consecutive events.
+inline void idleKernel(const double* t, size_t begin, size_t end, Partial& p) {
+    size_t i = std::max<size_t>(begin, 1);
+#ifdef RECORDER_SIMD_SSE2
+    const __m128d thr = _mm_set1_pd(ANALYTICS_IDLE_THRESHOLD);
+    for (; i + 2 <= end; i += 2) {
+        __m128d gap = _mm_sub_pd(_mm_loadu_pd(t + i), _mm_loadu_pd(t + i - 1));
+        if (_mm_movemask_pd(_mm_cmpge_pd(gap, thr)) == 0) continue;
+        double g[2];
+        _mm_storeu_pd(g, gap);
+        for (double v : g) {
+            if (v < ANALYTICS_IDLE_THRESHOLD) continue;
+            p.idleCount++; p.idleTotal += v; p.idleLongest = std::max(p.idleLongest, v);
+        }
+    }
+#endif
+    for (; i < end; ++i) {
+        double v = t[i] - t[i - 1];
+        if (v < ANALYTICS_IDLE_THRESHOLD) continue;
+        p.idleCount++; p.idleTotal += v; p.idleLongest = std::max(p.idleLongest, v);
+    }
+}
+
+// Runs fn(chunkIndex, begin, end) over n items on up to hardware_concurrency threads.
+template <typename Fn>
+inline void parallelChunks(size_t n, size_t chunks, Fn fn) {
+    if (chunks <= 1) { fn(0, 0, n); return; }
+    std::vector<std::thread> workers;
+    size_t per = (n + chunks - 1) / chunks;
+    for (size_t c = 0; c < chunks; ++c) {
+        size_t b = c * per, e = std::min(n, b + per);
+        if (b >= e) break;
+        workers.emplace_back(fn, c, b, e);
+    }
+    for (auto& w : workers) w.join();
+}
+
+inline size_t chunkCount(size_t n) {
+    size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    return std::max<size_t>(1, std::min(hw, n / 65536));
+}
+
+} // namespace analytics_detail
+
+inline RecordingStats analyzeRecording(const ColumnarRecording& c) {
+    using namespace analytics_detail;
+    RecordingStats st;
+    st.eventCount = c.time.size();
+    if (c.time.empty()) return st;
+    st.duration = c.time.back() - c.time.front();
+
+    // motion: speed column first, then histograms (acceleration needs speed[i-1])
+    size_t m = c.moveTime.size();
+    std::vector<double> speed(m);
+    size_t chunks = chunkCount(m);
+    std::vector<Partial> parts(std::max<size_t>(chunks, 1));
+    parallelChunks(m, chunks, [&](size_t ci, size_t b, size_t e) {
+        speedKernel(c.moveTime.data(), c.moveDx.data(), c.moveDy.data(), speed.data(), b, e, parts[ci]);
+    });
+    parallelChunks(m, chunks, [&](size_t ci, size_t b, size_t e) {
+        histogramKernel(c.moveTime.data(), speed.data(), b, e, parts[ci]);
+    });
+    size_t n = c.time.size();
+    size_t idleChunks = chunkCount(n);
+    std::vector<Partial> idleParts(std::max<size_t>(idleChunks, 1));
+    parallelChunks(n, idleChunks, [&](size_t ci, size_t b, size_t e) {
+        idleKernel(c.time.data(), b, e, idleParts[ci]);
+    });
+
+    for (const auto& p : parts) {
+        st.totalTravel += p.travel;
+        st.peakStep = std::max(st.peakStep, p.peakStep);
+        st.peakSpeed = std::max(st.peakSpeed, p.peakSpeed);
+        for (int b = 0; b < ANALYTICS_HIST_BINS; ++b) { st.velocityHist[b] += p.vel[b]; st.accelHist[b] += p.acc[b]; }
+    }
+    for (const auto& p : idleParts) {
+        st.idlePeriods += p.idleCount;
+        st.idleTotal += p.idleTotal;
+        st.idleLongest = std::max(st.idleLongest, p.idleLongest);
+    }
+
+    // discrete inputs and key holds are sparse; a scalar pass is enough
+    std::unordered_map<uint32_t, double> downAt;
+    double holdSum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        ActionType t = static_cast<ActionType>(c.type[i]);
+        if (t == ActionType::KEY_PRESS || t == ActionType::MOUSE_PRESS || t == ActionType::MOUSE_SCROLL) st.discreteInputs++;
+        if (t == ActionType::KEY_PRESS) {
+            downAt.emplace(c.vk[i], c.time[i]);
+        } else if (t == ActionType::KEY_RELEASE) {
+            auto it = downAt.find(c.vk[i]);
+            if (it == downAt.end()) continue;
+            double held = c.time[i] - it->second;
+            downAt.erase(it);
+            st.keyHolds++;
+            holdSum += held;
+            st.keyHoldMax = std::max(st.keyHoldMax, held);
+        }
+    }
+    if (st.keyHolds) st.keyHoldMean = holdSum / st.keyHolds;
+    if (st.duration > 0.0) st.inputsPerMinute = st.discreteInputs / (st.duration / 60.0);
+    return st;
+}
+
+inline nlohmann::json statsToJson(const RecordingStats& s) {
+    nlohmann::json j;
+    j["eventCount"] = s.eventCount; j["duration"] = s.duration;
+    j["totalTravel"] = s.totalTravel; j["peakStep"] = s.peakStep; j["peakSpeed"] = s.peakSpeed;
+    j["velocityHist"] = s.velocityHist; j["accelHist"] = s.accelHist;
+    j["discreteInputs"] = s.discreteInputs; j["inputsPerMinute"] = s.inputsPerMinute;
+    j["keyHolds"] = s.keyHolds; j["keyHoldMean"] = s.keyHoldMean; j["keyHoldMax"] = s.keyHoldMax;
+    j["idlePeriods"] = s.idlePeriods; j["idleTotal"] = s.idleTotal; j["idleLongest"] = s.idleLongest;
+    return j;
+}
+
+inline RecordingStats statsFromJson(const nlohmann::json& j) {
+    RecordingStats s;
+    s.eventCount = j.at("eventCount"); s.duration = j.at("duration");
+    s.totalTravel = j.at("totalTravel"); s.peakStep = j.at("peakStep"); s.peakSpeed = j.at("peakSpeed");
+    s.velocityHist = j.at("velocityHist"); s.accelHist = j.at("accelHist");
+    s.discreteInputs = j.at("discreteInputs"); s.inputsPerMinute = j.at("inputsPerMinute");
+    s.keyHolds = j.at("keyHolds"); s.keyHoldMean = j.at("keyHoldMean"); s.keyHoldMax = j.at("keyHoldMax");
+    s.idlePeriods = j.at("idlePeriods"); s.idleTotal = j.at("idleTotal"); s.idleLongest = j.at("idleLongest");
+    return s;
+}
+
+// Sidecar cache: "<recording>.stats", keyed on the recording's size and mtime.
+// Bump the version when the stats change meaning so stale sidecars are recomputed.
+static const int STATS_CACHE_VERSION = 2;
+
+inline std::string statsCachePath(const std::string& recordingPath) { return recordingPath + ".stats"; }
+
+inline bool loadCachedStats(const std::string& recordingPath, RecordingStats& out) {
+    try {
+        namespace fs = std::filesystem;
+        std::ifstream f(statsCachePath(recordingPath));
+        if (!f) return false;
+        nlohmann::json j = nlohmann::json::parse(f);
+        if (j.value("version", 1) != STATS_CACHE_VERSION) return false;
+        if (j.at("sourceSize").get<uintmax_t>() != fs::file_size(recordingPath)) return false;
+        if (j.at("sourceTime").get<long long>() != static_cast<long long>(fs::last_write_time(recordingPath).time_since_epoch().count())) return false;
+        out = statsFromJson(j.at("stats"));
+        return true;
+    } catch (...) { return false; }
+}
+
+inline void storeCachedStats(const std::string& recordingPath, const RecordingStats& s) {
+    try {
+        namespace fs = std::filesystem;
+        nlohmann::json j;
+        j["version"] = STATS_CACHE_VERSION;
+        j["sourceSize"] = fs::file_size(recordingPath);
+        j["sourceTime"] = static_cast<long long>(fs::last_write_time(recordingPath).time_since_epoch().count());
+        j["stats"] = statsToJson(s);
+        std::ofstream f(statsCachePath(recordingPath));
+        f << j.dump(2);
+    } catch (...) {}
+}
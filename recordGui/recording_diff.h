@@ -0,0 +1,248 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "recording.h"
+#include "recording_slice.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define RECORDER_SIMD_SSE2 1
+#endif
+
+static const double DIFF_FRAME_SEC     = 0.05;   // resampling grid for alignment
+static const double DIFF_BAND_SEC      = 10.0;   // max drift DTW may absorb either way
+static const float  DIFF_KEY_WEIGHT    = 20.0f;  // cost of one key/button state mismatch, in px
+static const float  DIFF_DIVERGE_COST  = 15.0f;  // local cost above which frames count as divergent
+static const double DIFF_MIN_SEGMENT   = 0.25;   // shorter divergent runs are ignored, seconds
+
+struct DiffSegment {
+    double refStart, refEnd;     // seconds in the reference
+    double takeStart, takeEnd;   // seconds in the compared take
+    double meanOffset;           // take minus reference, seconds
+    double maxDisplacement;      // px between the cumulative cursor paths
+    double meanCost;
+};
+
+struct DiffReport {
+    bool valid = false;
+    size_t refFrames = 0, takeFrames = 0;
+    double meanCost = 0.0;                       // per path step
+    double finalOffset = 0.0, maxOffset = 0.0;   // seconds
+    double finalDisplacement = 0.0, maxDisplacement = 0.0;
+    std::vector<DiffSegment> segments;
+};
+
+// One recording resampled onto the diff grid: motion per frame and the number
+// of keys/buttons held, plus the cumulative cursor path for error reporting.
+struct DiffFrames {
+    std::vector<float> dx, dy, held;
+    std::vector<double> posX, posY;
+    size_t size() const { return dx.size(); }
+
+    static DiffFrames fromActions(const std::vector<Action>& events) {
+        DiffFrames f;
+        if (events.empty()) return f;
+        double t0 = events.front().time;
+        size_t n = static_cast<size_t>((events.back().time - t0) / DIFF_FRAME_SEC) + 1;
+        f.dx.assign(n, 0.0f); f.dy.assign(n, 0.0f); f.held.assign(n, 0.0f);
+        f.posX.assign(n, 0.0); f.posY.assign(n, 0.0);
+        HeldState state;
+        double cx = 0.0, cy = 0.0;
+        size_t e = 0;
+        for (size_t b = 0; b < n; ++b) {
+            double end = t0 + (b + 1) * DIFF_FRAME_SEC;
+            for (; e < events.size() && events[e].time < end; ++e) {
+                const Action& a = events[e];
+                if (a.type == ActionType::MOUSE_MOVE || a.type == ActionType::MOUSE_DELTA) {
+                    f.dx[b] += static_cast<float>(a.deltaX);
+                    f.dy[b] += static_cast<float>(a.deltaY);
+                    cx += a.deltaX; cy += a.deltaY;
+                }
+                state.apply(a);
+            }
+            f.held[b] = static_cast<float>(state.count());
+            f.posX[b] = cx; f.posY[b] = cy;
+        }
+        return f;
+    }
+};
+
+namespace diff_detail {
+
+const float INF = std::numeric_limits<float>::infinity();
+
+enum : uint8_t { DIR_DIAG = 0, DIR_UP = 1, DIR_LEFT = 2 };
+
+// Local cost for one reference frame against take frames [0, count).
+inline void localCost(float ax, float ay, float ah, const float* bx, const float* by, const float* bh,
+                      float* out, size_t count) {
+    size_t j = 0;
+#ifdef RECORDER_SIMD_SSE2
+    const __m128 sign = _mm_set1_ps(-0.0f);
+    const __m128 vx = _mm_set1_ps(ax), vy = _mm_set1_ps(ay), vh = _mm_set1_ps(ah);
+    const __m128 w = _mm_set1_ps(DIFF_KEY_WEIGHT);
+    for (; j + 4 <= count; j += 4) {
+        __m128 cx = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(bx + j), vx));
+        __m128 cy = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(by + j), vy));
+        __m128 ch = _mm_andnot_ps(sign, _mm_sub_ps(_mm_loadu_ps(bh + j), vh));
+        _mm_storeu_ps(out + j, _mm_add_ps(_mm_add_ps(cx, cy), _mm_mul_ps(ch, w)));
+    }
+#endif
+    for (; j < count; ++j)
+        out[j] = std::fabs(bx[j] - ax) + std::fabs(by[j] - ay) + DIFF_KEY_WEIGHT * std::fabs(bh[j] - ah);
+}
+
+// best[j] = min(diag[j], up[j]) with the winning direction.
+inline void minOfPrev(const float* diag, const float* up, float* best, uint8_t* dir, size_t count) {
+    size_t j = 0;
+#ifdef RECORDER_SIMD_SSE2
+    for (; j + 4 <= count; j += 4) {
+        __m128 d = _mm_loadu_ps(diag + j), u = _mm_loadu_ps(up + j);
+        _mm_storeu_ps(best + j, _mm_min_ps(d, u));
+        int upWins = _mm_movemask_ps(_mm_cmplt_ps(u, d));
+        for (int k = 0; k < 4; ++k) dir[j + k] = (upWins >> k) & 1 ? DIR_UP : DIR_DIAG;
+    }
+#endif
+    for (; j < count; ++j) {
+        bool upWins = up[j] < diag[j];
+        best[j] = upWins ? up[j] : diag[j];
+        dir[j] = upWins ? DIR_UP : DIR_DIAG;
+    }
+}
+
+} // namespace diff_detail
+
+// Aligns `take` against `ref` with Sakoe-Chiba banded dynamic time warping.
+// Only a band of +-DIFF_BAND_SEC around the length-scaled diagonal is evaluated,
+// so time is O(n * band) and memory is one byte of traceback per band cell plus
+// two float rows. The per-row cost and the diag/up minimum are SSE2; the left
+// dependency is a short scalar pass.
+inline DiffReport diffRecordings(const std::vector<Action>& ref, const std::vector<Action>& take) {
+    using namespace diff_detail;
+    DiffReport rep;
+    DiffFrames a = DiffFrames::fromActions(ref), b = DiffFrames::fromActions(take);
+    const size_t n = a.size(), m = b.size();
+    rep.refFrames = n; rep.takeFrames = m;
+    if (n == 0 || m == 0) return rep;
+
+    const size_t radius = static_cast<size_t>(DIFF_BAND_SEC / DIFF_FRAME_SEC);
+    const size_t width = 2 * radius + 1;
+    auto bandLo = [&](size_t i) -> size_t {
+        size_t c = n > 1 ? static_cast<size_t>(std::llround(static_cast<double>(i) * (m - 1) / (n - 1))) : 0;
+        return c > radius ? c - radius : 0;
+    };
+    auto bandHi = [&](size_t i) -> size_t {   // exclusive
+        size_t c = n > 1 ? static_cast<size_t>(std::llround(static_cast<double>(i) * (m - 1) / (n - 1))) : 0;
+        return std::min(m, c + radius + 1);
+    };
+
+    std::vector<uint8_t> dirs(n * width, DIR_DIAG);
+    std::vector<float> prev(width + 1, INF), cur(width + 1, INF);
+    std::vector<float> cost(width), diag(width), up(width), best(width);
+    size_t prevLo = 0, prevHi = 0;
+
+    for (size_t i = 0; i < n; ++i) {
+        size_t lo = bandLo(i), hi = bandHi(i), cnt = hi - lo;
+        localCost(a.dx[i], a.dy[i], a.held[i], b.dx.data() + lo, b.dy.data() + lo, b.held.data() + lo, cost.data(), cnt);
+        // previous row re-indexed onto this row's columns
+        for (size_t k = 0; k < cnt; ++k) {
+            size_t j = lo + k;
+            up[k]   = (i > 0 && j >= prevLo && j < prevHi) ? prev[j - prevLo] : INF;
+            diag[k] = (i > 0 && j >= 1 && j - 1 >= prevLo && j - 1 < prevHi) ? prev[j - 1 - prevLo] : INF;
+        }
+        uint8_t* rowDir = dirs.data() + i * width;
+        minOfPrev(diag.data(), up.data(), best.data(), rowDir, cnt);
+        for (size_t k = 0; k < cnt; ++k) {
+            float left = k > 0 ? cur[k - 1] : INF;
+            float from = best[k];
+            if (left < from) { from = left; rowDir[k] = DIR_LEFT; }
+            if (i == 0 && lo + k == 0) from = 0.0f;
+            cur[k] = cost[k] + from;
+        }
+        std::swap(prev, cur);
+        prevLo = lo; prevHi = hi;
+    }
+    if (prevHi != m || !(prev[m - 1 - prevLo] < INF)) return rep;
+
+    // traceback from (n-1, m-1)
+    std::vector<std::pair<size_t, size_t>> path;
+    size_t i = n - 1, j = m - 1;
+    for (;;) {
+        path.push_back({i, j});
+        if (i == 0 && j == 0) break;
+        uint8_t d = dirs[i * width + (j - bandLo(i))];
+        if (i == 0) d = DIR_LEFT;
+        else if (j == 0) d = DIR_UP;
+        if (d == DIR_DIAG) { --i; --j; }
+        else if (d == DIR_UP) { --i; }
+        else { --j; }
+    }
+    std::reverse(path.begin(), path.end());
+
+    rep.valid = true;
+    double totalCost = 0.0;
+    size_t segStart = 0;
+    bool inSeg = false;
+    double segCost = 0.0, segOffset = 0.0, segDisp = 0.0;
+    auto flush = [&](size_t endIdx) {
+        size_t steps = endIdx - segStart;
+        const auto& s = path[segStart];
+        const auto& e = path[endIdx - 1];
+        double dur = (e.first - s.first + 1) * DIFF_FRAME_SEC;
+        if (dur >= DIFF_MIN_SEGMENT) {
+            rep.segments.push_back({ s.first * DIFF_FRAME_SEC, (e.first + 1) * DIFF_FRAME_SEC,
+                                     s.second * DIFF_FRAME_SEC, (e.second + 1) * DIFF_FRAME_SEC,
+                                     segOffset / steps, segDisp, segCost / steps });
+        }
+    };
+    for (size_t k = 0; k < path.size(); ++k) {
+        size_t pi = path[k].first, pj = path[k].second;
+        float c;
+        localCost(a.dx[pi], a.dy[pi], a.held[pi], &b.dx[pj], &b.dy[pj], &b.held[pj], &c, 1);
+        totalCost += c;
+        double offset = (static_cast<double>(pj) - static_cast<double>(pi)) * DIFF_FRAME_SEC;
+        double disp = std::hypot(b.posX[pj] - a.posX[pi], b.posY[pj] - a.posY[pi]);
+        rep.maxOffset = std::max(rep.maxOffset, std::fabs(offset));
+        rep.maxDisplacement = std::max(rep.maxDisplacement, disp);
+        if (c > DIFF_DIVERGE_COST) {
+            if (!inSeg) { inSeg = true; segStart = k; segCost = 0.0; segOffset = 0.0; segDisp = 0.0; }
+            segCost += c; segOffset += offset; segDisp = std::max(segDisp, disp);
+        } else if (inSeg) {
+            inSeg = false;
+            flush(k);
+        }
+    }
+    if (inSeg) flush(path.size());
+    rep.meanCost = totalCost / path.size();
+    rep.finalOffset = (static_cast<double>(m) - static_cast<double>(n)) * DIFF_FRAME_SEC;
+    rep.finalDisplacement = std::hypot(b.posX[m - 1] - a.posX[n - 1], b.posY[m - 1] - a.posY[n - 1]);
+    return rep;
+}
+
+inline std::string formatDiffReport(const DiffReport& r) {
+    std::ostringstream os;
+    os.setf(std::ios::fixed);
+    os.precision(2);
+    if (!r.valid) {
+        os << "Recordings could not be aligned (empty, or drift larger than " << DIFF_BAND_SEC << "s).\n";
+        return os.str();
+    }
+    os << "Reference frames: " << r.refFrames << ", take frames: " << r.takeFrames
+       << " (" << DIFF_FRAME_SEC * 1000.0 << " ms each)\n"
+       << "Mean cost per step: " << r.meanCost << "\n"
+       << "Time offset: final " << r.finalOffset << "s, max " << r.maxOffset << "s\n"
+       << "Displacement error: final " << r.finalDisplacement << " px, max " << r.maxDisplacement << " px\n"
+       << "Divergent segments: " << r.segments.size() << "\n";
+    for (const auto& s : r.segments) {
+        os << "  ref " << s.refStart << "-" << s.refEnd << "s  take " << s.takeStart << "-" << s.takeEnd
+           << "s  offset " << s.meanOffset << "s  max error " << s.maxDisplacement << " px  cost " << s.meanCost << "\n";
+    }
+    return os.str();
+}
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+#include "recording.h"
+#include "recording_slice.h"
+
+static const size_t EDIT_CHECKPOINT_EVERY = 1024;   // events between held-state checkpoints
+
+// An immutable, time-ordered take that pieces point into. Held key/button state
+// is checkpointed so the state at any event is found without a full scan.
+class EditSource {
+    std::vector<Action> events;
+    std::vector<HeldState> checkpoints;   // state before events[k * EDIT_CHECKPOINT_EVERY]
+
+public:
+    std::string name;
+
+    EditSource(std::vector<Action> timeOrdered, std::string sourceName)
+        : events(std::move(timeOrdered)), name(std::move(sourceName)) {
+        HeldState held;
+        for (size_t i = 0; i < events.size(); ++i) {
+            if (i % EDIT_CHECKPOINT_EVERY == 0) checkpoints.push_back(held);
+            held.apply(events[i]);
+        }
+    }
+
+    const std::vector<Action>& all() const { return events; }
+    // Exclusive end of the take: just past the last event, so a piece spanning
+    // [0, length()) holds every event, including those at the final timestamp.
+    double length() const {
+        return events.empty() ? 0.0 : std::nextafter(events.back().time, std::numeric_limits<double>::infinity());
+    }
+
+    // Index of the first event at or after t.
+    size_t indexAt(double t) const {
+        return std::lower_bound(events.begin(), events.end(), t,
+            [](const Action& a, double v) { return a.time < v; }) - events.begin();
+    }
+
+    // Keys and buttons down just before events[index].
+    HeldState heldBefore(size_t index) const {
+        if (checkpoints.empty()) return HeldState{};
+        size_t cp = std::min(index / EDIT_CHECKPOINT_EVERY, checkpoints.size() - 1);
+        HeldState held = checkpoints[cp];
+        for (size_t i = cp * EDIT_CHECKPOINT_EVERY; i < index && i < events.size(); ++i) held.apply(events[i]);
+        return held;
+    }
+};
+
+// A span [from, to) of a source's clock placed at `at` on the edited timeline.
+struct EditPiece {
+    std::shared_ptr<const EditSource> source;
+    double from = 0.0, to = 0.0;
+    double at = 0.0;
+
+    double length() const { return to - from; }
+    double end() const { return at + length(); }
+};
+
+// Piece table over immutable takes. Every edit rewrites only the piece list,
+// so cut, splice, concatenate, repeat and shift cost O(pieces) (plus a binary
+// search per split) no matter how long the takes are. Pieces are kept sorted
+// by `at` and never overlap; gaps between them are silence.
+class RecordingEditor {
+    std::vector<EditPiece> pieces;
+
+    // Ensures a piece boundary at t and returns the index of the first piece at or after t.
+    size_t splitAt(double t) {
+        size_t i = 0;
+        for (; i < pieces.size(); ++i) {
+            EditPiece& p = pieces[i];
+            if (t <= p.at) return i;
+            if (t < p.end()) {
+                EditPiece right = p;
+                right.from = p.from + (t - p.at);
+                right.at = t;
+                p.to = right.from;
+                pieces.insert(pieces.begin() + i + 1, right);
+                return i + 1;
+            }
+        }
+        return i;
+    }
+
+    void shiftFrom(size_t index, double dt) {
+        for (size_t i = index; i < pieces.size(); ++i) pieces[i].at += dt;
+    }
+
+    std::vector<EditPiece> copyRange(double t0, double t1) {
+        size_t a = splitAt(t0), b = splitAt(t1);
+        return std::vector<EditPiece>(pieces.begin() + a, pieces.begin() + b);
+    }
+
+public:
+    RecordingEditor() = default;
+    explicit RecordingEditor(std::shared_ptr<const EditSource> src) { reset(std::move(src)); }
+
+    void reset(std::shared_ptr<const EditSource> src) {
+        pieces.clear();
+        if (src && !src->all().empty()) pieces.push_back({ src, 0.0, src->length(), 0.0 });
+    }
+
+    bool empty() const { return pieces.empty(); }
+    size_t pieceCount() const { return pieces.size(); }
+    const std::vector<EditPiece>& pieceList() const { return pieces; }
+    double length() const { return pieces.empty() ? 0.0 : pieces.back().end(); }
+
+    // Removes [t0, t1) and closes the gap.
+    void cut(double t0, double t1) {
+        t0 = std::max(0.0, t0);
+        if (t1 <= t0) return;
+        size_t a = splitAt(t0), b = splitAt(t1);
+        pieces.erase(pieces.begin() + a, pieces.begin() + b);
+        shiftFrom(a, -(t1 - t0));
+    }
+
+    // Inserts the whole of `other` at t, pushing later material back.
+    void splice(double t, const RecordingEditor& other) {
+        t = std::max(0.0, t);
+        double len = other.length();
+        if (len <= 0.0) return;
+        size_t a = splitAt(t);
+        shiftFrom(a, len);
+        std::vector<EditPiece> ins = other.pieces;
+        for (auto& p : ins) p.at += t;
+        pieces.insert(pieces.begin() + a, ins.begin(), ins.end());
+    }
+
+    void concat(const RecordingEditor& other) { splice(length(), other); }
+
+    // Plays [t0, t1) `times` times in total; the copies follow the original.
+    void repeatRange(double t0, double t1, int times) {
+        t0 = std::max(0.0, t0);
+        if (t1 <= t0 || times <= 1) return;
+        std::vector<EditPiece> range = copyRange(t0, t1);
+        double len = t1 - t0;
+        size_t at = splitAt(t1);
+        shiftFrom(at, len * (times - 1));
+        std::vector<EditPiece> ins;
+        ins.reserve(range.size() * (times - 1));
+        for (int k = 1; k < times; ++k) {
+            for (EditPiece p : range) { p.at += len * k; ins.push_back(p); }
+        }
+        pieces.insert(pieces.begin() + at, ins.begin(), ins.end());
+    }
+
+    // Moves everything from t onward by dt: positive inserts silence, negative
+    // removes the dt seconds before t.
+    void timeShift(double t, double dt) {
+        t = std::max(0.0, t);
+        if (dt < 0.0) { cut(std::max(0.0, t + dt), t); return; }
+        shiftFrom(splitAt(t), dt);
+    }
+
+    // Builds the edited take. Each piece starts in the held state its source had
+    // at that point, so keys/buttons that differ from what the previous piece
+    // left down are released at the previous piece's end and pressed at the new
+    // piece's start; input held across a seamless boundary is left alone.
+    // Everything still down is released at the end.
+    std::vector<Action> materialize() const {
+        std::vector<Action> out;
+        size_t total = 0;
+        for (const auto& p : pieces) total += p.source->indexAt(p.to) - p.source->indexAt(p.from);
+        out.reserve(total + 16);
+
+        HeldState held;
+        double prevEnd = 0.0;
+        for (const auto& p : pieces) {
+            const auto& ev = p.source->all();
+            size_t first = p.source->indexAt(p.from), last = p.source->indexAt(p.to);
+            HeldState start = p.source->heldBefore(first);
+            held.emitReleasesUntil(start, prevEnd, out);
+            start.emitPressesSince(held, p.at, out);
+            held = start;
+            for (size_t i = first; i < last; ++i) {
+                Action a = ev[i];
+                a.time = p.at + (a.time - p.from);
+                held.apply(a);
+                out.push_back(a);
+            }
+            prevEnd = p.end();
+        }
+        held.emitReleasesUntil(HeldState{}, prevEnd, out);
+        for (size_t k = 0; k < out.size(); ++k) out[k].seq = k;
+        return out;
+    }
+};
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "recording.h"
+#include "event_tracks.h"
+
+inline nlohmann::json actionToJson(const Action& action) {
+    nlohmann::json actionJson;
+    actionJson["time"] = action.time;
+    switch (action.type) {
+        case ActionType::MOUSE_MOVE:
+            actionJson["type"] = "mouse_move";
+            actionJson["x"] = action.x; actionJson["y"] = action.y;
+            actionJson["deltaX"] = action.deltaX; actionJson["deltaY"] = action.deltaY;
+            break;
+        case ActionType::MOUSE_DELTA:
+            actionJson["type"] = "mouse_delta";
+            actionJson["deltaX"] = action.deltaX; actionJson["deltaY"] = action.deltaY;
+            actionJson["isRaw"] = true;
+            break;
+        case ActionType::MOUSE_PRESS:
+        case ActionType::MOUSE_RELEASE:
+            actionJson["type"] = (action.type == ActionType::MOUSE_PRESS) ? "mouse_press" : "mouse_release";
+            actionJson["x"] = action.x; actionJson["y"] = action.y;
+            actionJson["button"] = action.button;
+            break;
+        case ActionType::MOUSE_SCROLL:
+            actionJson["type"] = "mouse_scroll";
+            actionJson["x"] = action.x; actionJson["y"] = action.y;
+            actionJson["dx"] = action.scrollDx; actionJson["dy"] = action.scrollDy;
+            break;
+        case ActionType::KEY_PRESS:
+        case ActionType::KEY_RELEASE:
+            actionJson["type"] = (action.type == ActionType::KEY_PRESS) ? "key_press" : "key_release";
+            actionJson["key"] = action.key;
+            actionJson["vkCode"] = action.vkCode;
+            break;
+    }
+    return actionJson;
+}
+
+inline Action actionFromJson(const nlohmann::json& actionJson) {
+    Action action;
+    action.time = actionJson.at("time");
+    std::string typeStr = actionJson.at("type");
+    if (typeStr == "mouse_move") {
+        action.type = ActionType::MOUSE_MOVE;
+        action.x = actionJson.at("x"); action.y = actionJson.at("y");
+        if (actionJson.contains("deltaX")) action.deltaX = actionJson.at("deltaX");
+        if (actionJson.contains("deltaY")) action.deltaY = actionJson.at("deltaY");
+    } else if (typeStr == "mouse_delta") {
+        action.type = ActionType::MOUSE_DELTA;
+        action.deltaX = actionJson.at("deltaX"); action.deltaY = actionJson.at("deltaY");
+        action.isRawDelta = actionJson.value("isRaw", false);
+    } else if (typeStr == "mouse_press") {
+        action.type = ActionType::MOUSE_PRESS;
+        action.x = actionJson.at("x"); action.y = actionJson.at("y");
+        action.button = actionJson.at("button");
+    } else if (typeStr == "mouse_release") {
+        action.type = ActionType::MOUSE_RELEASE;
+        action.x = actionJson.at("x"); action.y = actionJson.at("y");
+        action.button = actionJson.at("button");
+    } else if (typeStr == "mouse_scroll") {
+        action.type = ActionType::MOUSE_SCROLL;
+        action.x = actionJson.at("x"); action.y = actionJson.at("y");
+        action.scrollDx = actionJson.at("dx"); action.scrollDy = actionJson.at("dy");
+    } else if (typeStr == "key_press") {
+        action.type = ActionType::KEY_PRESS;
+        action.key = actionJson.at("key");
+        action.vkCode = actionJson.value("vkCode", 0u);
+    } else if (typeStr == "key_release") {
+        action.type = ActionType::KEY_RELEASE;
+        action.key = actionJson.at("key");
+        action.vkCode = actionJson.value("vkCode", 0u);
+    }
+    return action;
+}
+
+// Reads a recording and returns it in time order. Files written before the
+// per-source tracks existed can be out of order; they are repaired here.
+inline bool readRecordingFile(const std::string& filename, std::vector<Action>& out) {
+    try {
+        std::ifstream file(filename);
+        nlohmann::json j = nlohmann::json::parse(file);
+        std::vector<Action> events;
+        events.reserve(j.size());
+        for (const auto& actionJson : j) {
+            Action action = actionFromJson(actionJson);
+            action.seq = events.size();
+            events.push_back(std::move(action));
+        }
+        repairTimeline(events);
+        out.swap(events);
+        return true;
+    } catch (...) { return false; }
+}
+
+// Streams events out of the merger one object per line, without building the whole document.
+inline bool writeRecordingFile(const std::string& filename, TimelineMerger& merger) {
+    try {
+        std::ofstream file(filename);
+        file << "[";
+        bool first = true;
+        while (const Action* a = merger.next()) {
+            file << (first ? "\n  " : ",\n  ") << actionToJson(*a).dump();
+            first = false;
+        }
+        file << "\n]\n";
+        return static_cast<bool>(file);
+    } catch (...) { return false; }
+}
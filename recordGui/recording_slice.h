@@ -0,0 +1,75 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+#include "recording.h"
+
+// Keys and mouse buttons held down at some point of a recording, keyed by
+// vkCode (or key name when vkCode is missing) and by button name.
+struct HeldState {
+    std::map<std::string, Action> keys;
+    std::map<std::string, Action> buttons;
+
+    static std::string keyId(const Action& a) {
+        return a.vkCode ? std::to_string(a.vkCode) : a.key;
+    }
+
+    void apply(const Action& a) {
+        switch (a.type) {
+            case ActionType::KEY_PRESS:     keys[keyId(a)] = a; break;
+            case ActionType::KEY_RELEASE:   keys.erase(keyId(a)); break;
+            case ActionType::MOUSE_PRESS:   buttons[a.button] = a; break;
+            case ActionType::MOUSE_RELEASE: buttons.erase(a.button); break;
+            default: break;
+        }
+    }
+
+    bool empty() const { return keys.empty() && buttons.empty(); }
+    size_t count() const { return keys.size() + buttons.size(); }
+
+    // Appends the presses needed to go from `from` to this state at time t.
+    void emitPressesSince(const HeldState& from, double t, std::vector<Action>& out) const {
+        for (const auto& kv : keys) {
+            if (from.keys.count(kv.first)) continue;
+            Action a = kv.second; a.time = t; out.push_back(a);
+        }
+        for (const auto& kv : buttons) {
+            if (from.buttons.count(kv.first)) continue;
+            Action a = kv.second; a.time = t; out.push_back(a);
+        }
+    }
+
+    // Appends releases for everything held here but not in `to`.
+    void emitReleasesUntil(const HeldState& to, double t, std::vector<Action>& out) const {
+        for (const auto& kv : keys) {
+            if (to.keys.count(kv.first)) continue;
+            Action a = kv.second; a.type = ActionType::KEY_RELEASE; a.time = t; out.push_back(a);
+        }
+        for (const auto& kv : buttons) {
+            if (to.buttons.count(kv.first)) continue;
+            Action a = kv.second; a.type = ActionType::MOUSE_RELEASE; a.time = t; out.push_back(a);
+        }
+    }
+};
+
+// Events of a time-ordered recording in [t0, t1), rebased to start at 0. Keys and
+// buttons already down at t0 are pressed at 0 and everything still down at the
+// end is released, so the slice plays (and loops) without stuck input.
+inline std::vector<Action> sliceRecording(const std::vector<Action>& events, double t0, double t1) {
+    std::vector<Action> out;
+    HeldState before, held;
+    size_t i = 0;
+    for (; i < events.size() && events[i].time < t0; ++i) before.apply(events[i]);
+    before.emitPressesSince(HeldState{}, 0.0, out);
+    held = before;
+    for (; i < events.size() && events[i].time < t1; ++i) {
+        Action a = events[i];
+        a.time -= t0;
+        held.apply(a);
+        out.push_back(a);
+    }
+    held.emitReleasesUntil(HeldState{}, t1 - t0, out);
+    for (size_t k = 0; k < out.size(); ++k) out[k].seq = k;
+    return out;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include "recording.h"
+#include "raw_smoother.h"
+
+static const double TUNE_REST_GAP = 0.05;   // raw silence after motion that counts as a stop, seconds
+
+struct TuneCandidate {
+    SmootherParams params;
+    double displacementError = 0.0;   // |sum(output) - sum(raw)|, px
+    double overshoot = 0.0;           // output motion emitted while the hand was at rest, px
+    size_t eventCount = 0;            // output MOUSE_DELTA events
+    bool pareto = false;
+};
+
+// Replays the raw processor over a captured raw-delta stream. Idle ticks are
+// reconstructed from the gaps between deltas, as the live loop would have slept.
+inline void scoreCandidate(const std::vector<RawDelta>& raw, TuneCandidate& c) {
+    RawSmoother sm(c.params);
+    std::vector<Action> out;
+    out.reserve(raw.size() + raw.size() / 4);
+    double prevTime = raw.empty() ? 0.0 : raw.front().time;
+    double rawX = 0.0, rawY = 0.0;
+    for (const auto& rd : raw) {
+        long idle = static_cast<long>((rd.time - prevTime) * 1000.0 / c.params.tickMs);
+        for (long k = 0; k < idle; ++k) sm.idleTick();
+        prevTime = rd.time;
+        rawX += rd.dx; rawY += rd.dy;
+        sm.feed(rd, [&](const Action& a) { out.push_back(a); });
+    }
+    std::stable_sort(out.begin(), out.end(), [](const Action& a, const Action& b) { return a.time < b.time; });
+
+    double outX = 0.0, outY = 0.0;
+    for (const auto& a : out) { outX += a.deltaX; outY += a.deltaY; }
+    c.displacementError = std::hypot(outX - rawX, outY - rawY);
+    c.eventCount = out.size();
+
+    // Rest intervals run from a moving raw delta to the next one when the gap
+    // exceeds TUNE_REST_GAP (and after the last one); output there is overshoot.
+    std::vector<std::pair<double, double>> rests;
+    double lastMove = -1.0;
+    for (const auto& rd : raw) {
+        if (std::max(std::abs(rd.dx), std::abs(rd.dy)) <= 1) continue;
+        if (lastMove >= 0.0 && rd.time - lastMove > TUNE_REST_GAP) rests.push_back({ lastMove, rd.time });
+        lastMove = rd.time;
+    }
+    if (lastMove >= 0.0) rests.push_back({ lastMove, 1e300 });
+    c.overshoot = 0.0;
+    size_t r = 0;
+    for (const auto& a : out) {
+        while (r < rests.size() && rests[r].second <= a.time) ++r;
+        if (r == rests.size()) break;
+        if (a.time > rests[r].first) c.overshoot += std::hypot(a.deltaX, a.deltaY);
+    }
+}
+
+// Full grid over the tunables around the current defaults.
+inline std::vector<SmootherParams> gridCandidates(const SmootherParams& base) {
+    std::vector<SmootherParams> out;
+    for (double alpha : { 0.3, 0.4, 0.5, 0.6, 0.7, 0.8, 0.9 })
+        for (int thr : { 0, 1, 2, 3 })
+            for (int frames : { 1, 2, 3, 4 })
+                for (int ramp : { 0, 20, 40, 60, 80 })
+                    for (double decay : { 0.3, 0.45, 0.6, 0.75 }) {
+                        if (ramp == 0 && decay != 0.3) continue;   // decay is unused without a ramp
+                        SmootherParams p = base;
+                        p.alpha = alpha; p.stopThreshold = thr; p.stopFrames = frames;
+                        p.rampMs = ramp; p.ramp = ramp > 0; p.rampDecay = decay;
+                        out.push_back(p);
+                    }
+    return out;
+}
+
+inline std::vector<SmootherParams> randomCandidates(const SmootherParams& base, size_t count, uint32_t seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> alpha(0.2, 0.95), decay(0.2, 0.85);
+    std::uniform_int_distribution<int> thr(0, 4), frames(1, 6), ramp(0, 120);
+    std::vector<SmootherParams> out;
+    out.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        SmootherParams p = base;
+        p.alpha = alpha(rng); p.stopThreshold = thr(rng); p.stopFrames = frames(rng);
+        p.rampMs = ramp(rng); p.ramp = p.rampMs > 0; p.rampDecay = decay(rng);
+        out.push_back(p);
+    }
+    return out;
+}
+
+inline bool dominates(const TuneCandidate& a, const TuneCandidate& b) {
+    bool noWorse = a.displacementError <= b.displacementError && a.overshoot <= b.overshoot && a.eventCount <= b.eventCount;
+    bool better = a.displacementError < b.displacementError || a.overshoot < b.overshoot || a.eventCount < b.eventCount;
+    return noWorse && better;
+}
+
+// Scores every parameter set on all cores and marks the Pareto front
+// (minimising displacement error, overshoot and event count).
+inline std::vector<TuneCandidate> sweepParameters(const std::vector<RawDelta>& raw, const std::vector<SmootherParams>& sets) {
+    std::vector<TuneCandidate> results(sets.size());
+    for (size_t i = 0; i < sets.size(); ++i) results[i].params = sets[i];
+    std::atomic<size_t> next{0};
+    size_t workers = std::max(1u, std::thread::hardware_concurrency());
+    std::vector<std::thread> pool;
+    for (size_t w = 0; w < workers; ++w) {
+        pool.emplace_back([&]() {
+            for (size_t i; (i = next.fetch_add(1)) < results.size();) scoreCandidate(raw, results[i]);
+        });
+    }
+    for (auto& t : pool) t.join();
+
+    for (auto& c : results) {
+        c.pareto = std::none_of(results.begin(), results.end(), [&](const TuneCandidate& o) { return dominates(o, c); });
+    }
+    return results;
+}
+
+// The front, ordered by a balanced score (each objective normalised to the front's max).
+inline std::vector<TuneCandidate> paretoFront(const std::vector<TuneCandidate>& all) {
+    std::vector<TuneCandidate> front;
+    for (const auto& c : all) if (c.pareto) front.push_back(c);
+    double maxErr = 1e-9, maxOver = 1e-9, maxCount = 1.0;
+    for (const auto& c : front) {
+        maxErr = std::max(maxErr, c.displacementError);
+        maxOver = std::max(maxOver, c.overshoot);
+        maxCount = std::max(maxCount, static_cast<double>(c.eventCount));
+    }
+    auto score = [&](const TuneCandidate& c) {
+        return c.displacementError / maxErr + c.overshoot / maxOver + c.eventCount / maxCount;
+    };
+    std::sort(front.begin(), front.end(), [&](const TuneCandidate& a, const TuneCandidate& b) { return score(a) < score(b); });
+    return front;
+}
+
+inline nlohmann::json candidateToJson(const TuneCandidate& c) {
+    nlohmann::json j;
+    j["TUNING_SMOOTH_ALPHA"] = c.params.alpha;
+    j["TUNING_STOP_THRESHOLD"] = c.params.stopThreshold;
+    j["TUNING_STOP_FRAMES"] = c.params.stopFrames;
+    j["STOP_RAMP_MS"] = c.params.rampMs;
+    j["RAMP_DECAY"] = c.params.rampDecay;
+    j["ENABLE_PLAYBACK_RAMP"] = c.params.ramp;
+    j["displacementError"] = c.displacementError;
+    j["overshoot"] = c.overshoot;
+    j["eventCount"] = c.eventCount;
+    return j;
+}
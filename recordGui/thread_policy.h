@@ -0,0 +1,275 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+// Scheduling policy for the engine threads: the capture thread (LL hooks and
+// WM_INPUT), the processing threads (raw smoother, control plane) and playback.
+// Everything is best effort: a setting the OS refuses (no CAP_SYS_NICE, no
+// SeLockMemoryPrivilege...) is reported through the return value and otherwise
+// ignored, so the recorder behaves as before on an unprivileged account.
+
+static const char* THREAD_POLICY_FILE = "thread_policy.json";
+
+enum class ThreadPriorityLevel { NORMAL, ABOVE_NORMAL, HIGHEST, TIME_CRITICAL };
+
+struct ThreadPolicy {
+    std::vector<int> cpus;                                   // empty = any CPU
+    ThreadPriorityLevel priority = ThreadPriorityLevel::NORMAL;
+    bool realtime = false;                                   // SCHED_FIFO / time-critical in a high-priority process
+    int rtPriority = 50;                                     // SCHED_FIFO priority, 1..99 (Linux only)
+    size_t stackPrefault = 0;                                // bytes of stack touched at thread start
+};
+
+struct ThreadPolicyConfig {
+    ThreadPolicy capture{ {}, ThreadPriorityLevel::HIGHEST };
+    ThreadPolicy processing{ {}, ThreadPriorityLevel::HIGHEST };
+    ThreadPolicy control{};
+    ThreadPolicy playback{ {}, ThreadPriorityLevel::HIGHEST };
+    bool lockMemory = false;           // lock capture/playback buffers into RAM
+    // Per-track capacity reserved and faulted in before every take (and also
+    // locked with lockMemory). A take that outgrows it still records, but each
+    // regrowth copies the track on the capturing thread and is re-locked up to
+    // 100 ms later.
+    size_t prefaultEvents = 16384;
+};
+
+inline const char* priorityName(ThreadPriorityLevel p) {
+    switch (p) {
+        case ThreadPriorityLevel::ABOVE_NORMAL:  return "above_normal";
+        case ThreadPriorityLevel::HIGHEST:       return "highest";
+        case ThreadPriorityLevel::TIME_CRITICAL: return "time_critical";
+        default:                                 return "normal";
+    }
+}
+
+inline ThreadPriorityLevel priorityFromName(const std::string& s, ThreadPriorityLevel fallback) {
+    if (s == "normal") return ThreadPriorityLevel::NORMAL;
+    if (s == "above_normal") return ThreadPriorityLevel::ABOVE_NORMAL;
+    if (s == "highest") return ThreadPriorityLevel::HIGHEST;
+    if (s == "time_critical") return ThreadPriorityLevel::TIME_CRITICAL;
+    return fallback;
+}
+
+inline void threadPolicyFromJson(const nlohmann::json& j, ThreadPolicy& p) {
+    if (!j.is_object()) return;
+    if (j.contains("cpus")) p.cpus = j.at("cpus").get<std::vector<int>>();
+    p.priority = priorityFromName(j.value("priority", std::string()), p.priority);
+    p.realtime = j.value("realtime", p.realtime);
+    p.rtPriority = std::min(99, std::max(1, j.value("rtPriority", p.rtPriority)));
+    p.stackPrefault = j.value("stackPrefault", p.stackPrefault);
+}
+
+// Missing file or keys keep the defaults.
+inline ThreadPolicyConfig loadThreadPolicyConfig(const std::string& path = THREAD_POLICY_FILE) {
+    ThreadPolicyConfig c;
+    try {
+        std::ifstream f(path);
+        if (!f) return c;
+        nlohmann::json j = nlohmann::json::parse(f);
+        if (j.contains("capture")) threadPolicyFromJson(j["capture"], c.capture);
+        if (j.contains("processing")) threadPolicyFromJson(j["processing"], c.processing);
+        if (j.contains("control")) threadPolicyFromJson(j["control"], c.control);
+        if (j.contains("playback")) threadPolicyFromJson(j["playback"], c.playback);
+        c.lockMemory = j.value("lockMemory", c.lockMemory);
+        c.prefaultEvents = j.value("prefaultEvents", c.prefaultEvents);
+    } catch (...) {}
+    return c;
+}
+
+// Touches `bytes` of the calling thread's stack so later deep calls don't page-fault.
+inline void prefaultStack(size_t bytes) {
+    const size_t CHUNK = 4096;
+    volatile unsigned char page[CHUNK];
+    page[0] = 0;
+    if (bytes > CHUNK) prefaultStack(bytes - CHUNK);
+    page[CHUNK - 1] = page[0];
+}
+
+// Applies the policy to the calling thread. Returns false if any part was refused.
+inline bool applyThreadPolicy(const ThreadPolicy& p) {
+    bool ok = true;
+#ifdef _WIN32
+    if (!p.cpus.empty()) {
+        DWORD_PTR mask = 0;
+        for (int cpu : p.cpus) if (cpu >= 0 && cpu < static_cast<int>(sizeof(DWORD_PTR) * 8)) mask |= DWORD_PTR(1) << cpu;
+        if (!mask || !SetThreadAffinityMask(GetCurrentThread(), mask)) ok = false;
+    }
+    int prio = THREAD_PRIORITY_NORMAL;
+    switch (p.priority) {
+        case ThreadPriorityLevel::ABOVE_NORMAL:  prio = THREAD_PRIORITY_ABOVE_NORMAL; break;
+        case ThreadPriorityLevel::HIGHEST:       prio = THREAD_PRIORITY_HIGHEST; break;
+        case ThreadPriorityLevel::TIME_CRITICAL: prio = THREAD_PRIORITY_TIME_CRITICAL; break;
+        default: break;
+    }
+    if (p.realtime) {
+        // REALTIME_PRIORITY_CLASS can starve the input stack the LL hooks depend on.
+        if (!SetPriorityClass(GetCurrentProcess(), HIGH_PRIORITY_CLASS)) ok = false;
+        prio = THREAD_PRIORITY_TIME_CRITICAL;
+    }
+    if (!SetThreadPriority(GetCurrentThread(), prio)) ok = false;
+#else
+    if (!p.cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : p.cpus) if (cpu >= 0 && cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0) ok = false;
+    }
+    if (p.realtime) {
+        sched_param sp{};
+        sp.sched_priority = p.rtPriority;
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp) != 0) ok = false;
+    } else {
+        // Per-thread nice value; negative values need CAP_SYS_NICE.
+        int nice = 0;
+        switch (p.priority) {
+            case ThreadPriorityLevel::ABOVE_NORMAL:  nice = -5; break;
+            case ThreadPriorityLevel::HIGHEST:       nice = -10; break;
+            case ThreadPriorityLevel::TIME_CRITICAL: nice = -15; break;
+            default: break;
+        }
+        pid_t tid = static_cast<pid_t>(syscall(SYS_gettid));
+        if (setpriority(PRIO_PROCESS, static_cast<id_t>(tid), nice) != 0) ok = false;
+    }
+#endif
+    if (p.stackPrefault) prefaultStack(p.stackPrefault);
+    return ok;
+}
+
+#ifdef _WIN32
+// VirtualLock is bounded by the minimum working set, so every locked byte is
+// added to it while locked and taken off again when released.
+inline void adjustWorkingSet(size_t bytes, bool grow) {
+    SIZE_T minWs = 0, maxWs = 0;
+    if (!GetProcessWorkingSetSize(GetCurrentProcess(), &minWs, &maxWs)) return;
+    SIZE_T newMin = grow ? minWs + bytes : (minWs > bytes ? minWs - bytes : minWs);
+    SetProcessWorkingSetSize(GetCurrentProcess(), newMin, std::max<SIZE_T>(maxWs, newMin));
+}
+#endif
+
+// Faults in and pins a buffer so the capture/playback paths never take a page
+// fault on it. Every successful lock must be paired with unlockBuffer() or,
+// if the buffer was freed meanwhile, forgetLockedBuffer().
+inline bool lockBuffer(const void* data, size_t bytes) {
+    if (!data || !bytes) return true;
+#ifdef _WIN32
+    adjustWorkingSet(bytes, true);
+    if (VirtualLock(const_cast<void*>(data), bytes)) return true;
+    adjustWorkingSet(bytes, false);
+    return false;
+#else
+    return mlock(data, bytes) == 0;
+#endif
+}
+
+inline void unlockBuffer(const void* data, size_t bytes) {
+    if (!data || !bytes) return;
+#ifdef _WIN32
+    VirtualUnlock(const_cast<void*>(data), bytes);
+    adjustWorkingSet(bytes, false);
+#else
+    munlock(data, bytes);
+#endif
+}
+
+// A locked buffer that has since been freed (a vector that reallocated). Buffers
+// this large are returned to the OS on free and their lock goes with the pages,
+// so the range must not be unlocked again: it may already belong to someone else.
+inline void forgetLockedBuffer(size_t bytes) {
+#ifdef _WIN32
+    adjustWorkingSet(bytes, false);
+#else
+    (void)bytes;
+#endif
+}
+
+// The locked ranges of a set of growable buffers, one slot per buffer.
+// refresh() is given each buffer's current range; a buffer that moved is
+// locked again at its new address and its old entry dropped, not unlocked.
+class LockedBuffers {
+    std::vector<std::pair<const void*, size_t>> ranges;
+
+public:
+    void refresh(size_t slot, const void* data, size_t bytes) {
+        if (slot >= ranges.size()) ranges.resize(slot + 1, { nullptr, 0 });
+        auto& r = ranges[slot];
+        if (r.first == data && r.second == bytes) return;
+        if (r.first) forgetLockedBuffer(r.second);
+        r = { nullptr, 0 };
+        if (data && bytes && lockBuffer(data, bytes)) r = { data, bytes };
+    }
+
+    // Unlocks the slot if the buffer is still where it was locked, otherwise
+    // only forgets it.
+    void release(size_t slot, const void* data, size_t bytes) {
+        if (slot >= ranges.size() || !ranges[slot].first) return;
+        auto& r = ranges[slot];
+        if (r.first == data && r.second == bytes) unlockBuffer(r.first, r.second);
+        else forgetLockedBuffer(r.second);
+        r = { nullptr, 0 };
+    }
+};
+
+// Wakeup lateness of a periodic thread: how long after each absolute deadline
+// the thread actually runs. Used to compare policies on the build hosts.
+struct LatenessStats {
+    size_t samples = 0;
+    double meanUs = 0.0, p50Us = 0.0, p99Us = 0.0, maxUs = 0.0;
+    bool policyApplied = false;
+};
+
+inline LatenessStats measureSchedulingLateness(const ThreadPolicy& policy, std::chrono::microseconds period, size_t iterations) {
+    LatenessStats st;
+    std::vector<double> late;
+    late.reserve(iterations);
+    std::thread worker([&]() {
+        st.policyApplied = applyThreadPolicy(policy);
+#ifdef _WIN32
+        auto next = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            next += period;
+            std::this_thread::sleep_until(next);
+            late.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - next).count());
+        }
+#else
+        timespec next, now;
+        clock_gettime(CLOCK_MONOTONIC, &next);
+        for (size_t i = 0; i < iterations; ++i) {
+            next.tv_nsec += static_cast<long>(period.count()) * 1000;
+            while (next.tv_nsec >= 1000000000L) { next.tv_nsec -= 1000000000L; next.tv_sec++; }
+            while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr) != 0) {}
+            clock_gettime(CLOCK_MONOTONIC, &now);
+            late.push_back((now.tv_sec - next.tv_sec) * 1e6 + (now.tv_nsec - next.tv_nsec) / 1e3);
+        }
+#endif
+    });
+    worker.join();
+    if (late.empty()) return st;
+    st.samples = late.size();
+    for (double v : late) st.meanUs += v;
+    st.meanUs /= late.size();
+    std::sort(late.begin(), late.end());
+    st.p50Us = late[late.size() / 2];
+    st.p99Us = late[std::min(late.size() - 1, late.size() * 99 / 100)];
+    st.maxUs = late.back();
+    return st;
+}
@@ -0,0 +1,93 @@
+// Consistency checks for the piece-table editor (recording_editor.h).
+// Platform-neutral; build and run from recordGui/:
+//   g++ -std=c++17 -O2 -I. tools/editor_check.cpp -o editor_check && ./editor_check
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+#include "recording_editor.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { std::printf("FAIL %s:%d: ", __FILE__, __LINE__); std::printf(__VA_ARGS__); std::printf("\n"); failures++; } } while (0)
+
+static Action event(double t, ActionType type, uint32_t vk = 0, const char* button = "") {
+    Action a;
+    a.time = t;
+    a.type = type;
+    a.vkCode = vk;
+    a.key = vk ? "k" + std::to_string(vk) : "";
+    a.button = button;
+    return a;
+}
+
+static bool sameEvent(const Action& a, const Action& b) {
+    return a.type == b.type && a.time == b.time && a.vkCode == b.vkCode && a.key == b.key && a.button == b.button
+        && a.x == b.x && a.y == b.y && a.deltaX == b.deltaX && a.deltaY == b.deltaY
+        && a.scrollDx == b.scrollDx && a.scrollDy == b.scrollDy && a.isRawDelta == b.isRawDelta;
+}
+
+// A take that ends with every key/button released, with several events on the final timestamp.
+static std::vector<Action> sampleTake() {
+    std::vector<Action> ev;
+    ev.push_back(event(0.00, ActionType::KEY_PRESS, 87));
+    for (int i = 1; i <= 300; ++i) {
+        Action d = event(i * 0.01, ActionType::MOUSE_DELTA);
+        d.deltaX = 1.0; d.isRawDelta = true;
+        ev.push_back(d);
+    }
+    ev.push_back(event(1.50, ActionType::MOUSE_PRESS, 0, "left"));
+    ev.push_back(event(2.00, ActionType::MOUSE_RELEASE, 0, "left"));
+    ev.push_back(event(3.00, ActionType::KEY_RELEASE, 87));
+    Action last = event(3.00, ActionType::MOUSE_DELTA);
+    last.deltaX = 5.0; last.isRawDelta = true;
+    ev.push_back(last);
+    std::stable_sort(ev.begin(), ev.end(), [](const Action& a, const Action& b) { return a.time < b.time; });
+    return ev;
+}
+
+static void checkRoundTrip() {
+    std::vector<Action> take = sampleTake();
+    RecordingEditor editor(std::make_shared<const EditSource>(take, "take"));
+    std::vector<Action> out = editor.materialize();
+    CHECK(out.size() == take.size(), "unedited take materialized to %zu events, source has %zu", out.size(), take.size());
+    for (size_t i = 0; i < std::min(out.size(), take.size()); ++i) {
+        CHECK(sameEvent(out[i], take[i]), "event %zu differs after round trip", i);
+    }
+}
+
+static void checkConcatKeepsTails() {
+    std::vector<Action> take = sampleTake();
+    auto src = std::make_shared<const EditSource>(take, "take");
+    RecordingEditor editor(src);
+    editor.concat(RecordingEditor(src));
+    std::vector<Action> out = editor.materialize();
+    CHECK(out.size() == 2 * take.size(), "concat of two takes gave %zu events, expected %zu", out.size(), 2 * take.size());
+    double dx = 0.0;
+    for (const auto& a : out) dx += a.deltaX;
+    CHECK(dx == 2 * 305.0, "concat lost motion: %.1f px", dx);
+}
+
+static void checkHeldFixups() {
+    std::vector<Action> take = sampleTake();
+    RecordingEditor editor(std::make_shared<const EditSource>(take, "take"));
+    editor.cut(0.0, 1.0);              // starts with W already held
+    editor.repeatRange(0.0, 0.5, 3);   // W held across the seams: no extra presses
+    std::vector<Action> out = editor.materialize();
+    int presses = 0, releases = 0;
+    for (const auto& a : out) {
+        if (a.type == ActionType::KEY_PRESS) presses++;
+        if (a.type == ActionType::KEY_RELEASE) releases++;
+        CHECK(&a == &out.front() || (&a - 1)->time <= a.time, "output not time ordered at %.3f", a.time);
+    }
+    CHECK(presses == 1 && releases == 1, "W pressed %d times, released %d times", presses, releases);
+}
+
+int main() {
+    checkRoundTrip();
+    checkConcatKeepsTails();
+    checkHeldFixups();
+    if (failures) { std::printf("%d check(s) failed\n", failures); return 1; }
+    std::printf("editor checks passed\n");
+    return 0;
+}
@@ -0,0 +1,154 @@
+// Multi-process checks for the live event stream (event_stream.h), using
+// fork() and a POSIX shm region exactly as external readers would. Linux.
+//   - a fast reader gets every event, in order, with no overruns
+//   - a slow reader reports overruns and never sees events out of order;
+//     received + overruns accounts for every event
+//   - the writer never blocks: it finishes while a reader is SIGSTOPped
+//   - a writer restart (reformat under attached readers) is seen as one
+//     restart, not as an overrun storm
+// Build and run from recordGui/:
+//   g++ -std=c++17 -O2 -I. tools/event_stream_check.cpp -o event_stream_check -pthread && ./event_stream_check
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "event_stream.h"
+
+static const uint32_t CAPACITY = 1024;       // small, so the run wraps the ring many times
+static const uint64_t EVENTS = 200000;
+static const uint64_t BATCH = 256;           // paced so a reader that keeps up never falls a ring behind
+static const uint64_t RESTART_EVENTS = 100;
+
+// Results the children hand back, in an anonymous shared mapping made before fork().
+struct ReaderResult {
+    std::atomic<bool> attached{false};
+    uint64_t received = 0, overruns = 0, restarts = 0;
+    uint64_t outOfOrder = 0, lastSeq = 0;
+    uint64_t afterRestart = 0;    // events read in the second generation
+    bool afterRestartInOrder = true;
+};
+
+struct Shared {
+    std::atomic<int> phase{0};   // 0 running, 1 first writer done, 2 restarted writer done
+    ReaderResult fast, slow, stopped;
+};
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { std::printf("FAIL %s:%d: ", __FILE__, __LINE__); std::printf(__VA_ARGS__); std::printf("\n"); failures++; } } while (0)
+
+static void runReader(const std::string& name, ReaderResult& res, Shared& sh, std::chrono::microseconds perEvent) {
+    SharedEventStream stream;
+    if (!stream.open(name)) _exit(2);
+    StreamReader reader;
+    reader.attach(stream.ring(), false);
+    res.attached = true;
+    bool first = true;
+    uint64_t restartsSeen = 0;
+    for (;;) {
+        int phase = sh.phase.load();
+        StreamEvent e;
+        if (reader.read(e)) {
+            if (reader.restartCount() != restartsSeen) { restartsSeen = reader.restartCount(); first = true; }
+            if (restartsSeen == 0) {
+                if (!first && e.seq <= res.lastSeq) res.outOfOrder++;
+                res.lastSeq = e.seq;
+                res.received++;
+            } else {
+                if (e.seq != res.afterRestart) res.afterRestartInOrder = false;
+                res.afterRestart++;
+            }
+            first = false;
+            if (perEvent.count()) std::this_thread::sleep_for(perEvent);
+            continue;
+        }
+        if (phase == 2) break;
+        std::this_thread::yield();
+    }
+    res.overruns = reader.overrunCount();
+    res.restarts = reader.restartCount();
+    _exit(0);
+}
+
+static void publishAll(SharedEventStream& stream, uint64_t count) {
+    Action a;
+    a.type = ActionType::MOUSE_DELTA;
+    for (uint64_t i = 0; i < count; ++i) {
+        a.seq = i;
+        a.time = i * 0.001;
+        stream.publish(a, STREAM_CAPTURED);
+        if ((i + 1) % BATCH == 0) std::this_thread::sleep_for(std::chrono::microseconds(500));
+    }
+}
+
+int main() {
+    auto* sh = new (mmap(nullptr, sizeof(Shared), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0)) Shared();
+    std::string name = "/record_all_stream_check_" + std::to_string(getpid());
+
+    SharedEventStream writer;
+    if (!writer.create(name, CAPACITY)) { std::printf("create failed\n"); return 1; }
+
+    pid_t fast = fork();
+    if (fast == 0) runReader(name, sh->fast, *sh, std::chrono::microseconds(0));
+    pid_t slow = fork();
+    if (slow == 0) runReader(name, sh->slow, *sh, std::chrono::microseconds(50));
+    pid_t stopped = fork();
+    if (stopped == 0) runReader(name, sh->stopped, *sh, std::chrono::microseconds(0));
+    while (!sh->fast.attached || !sh->slow.attached || !sh->stopped.attached) std::this_thread::yield();
+
+    // freeze one reader for the whole run: publish is wait-free, so the writer can't notice
+    kill(stopped, SIGSTOP);
+    auto t0 = std::chrono::steady_clock::now();
+    publishAll(writer, EVENTS);
+    double writerSec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    CHECK(writer.ring().head() == EVENTS, "writer published %llu of %llu events",
+        static_cast<unsigned long long>(writer.ring().head()), static_cast<unsigned long long>(EVENTS));
+    kill(stopped, SIGCONT);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));   // let readers drain generation 1
+    sh->phase = 1;
+
+    // a restarted recorder reformats the live region under the attached readers
+    SharedEventStream restarted;
+    if (!restarted.create(name, CAPACITY)) { std::printf("re-create failed\n"); return 1; }
+    publishAll(restarted, RESTART_EVENTS);
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    sh->phase = 2;
+
+    for (pid_t p : { fast, slow, stopped }) {
+        int status = 0;
+        waitpid(p, &status, 0);
+        CHECK(WIFEXITED(status) && WEXITSTATUS(status) == 0, "reader %d exited abnormally", static_cast<int>(p));
+    }
+
+    const ReaderResult& f = sh->fast;
+    CHECK(f.received == EVENTS && f.overruns == 0 && f.outOfOrder == 0,
+        "fast reader: %llu received, %llu overruns, %llu out of order", static_cast<unsigned long long>(f.received),
+        static_cast<unsigned long long>(f.overruns), static_cast<unsigned long long>(f.outOfOrder));
+    for (const ReaderResult* r : { &sh->slow, &sh->stopped }) {
+        const char* which = r == &sh->slow ? "slow" : "stopped";
+        CHECK(r->overruns > 0, "%s reader reported no overruns", which);
+        CHECK(r->outOfOrder == 0, "%s reader saw %llu events out of order", which, static_cast<unsigned long long>(r->outOfOrder));
+        CHECK(r->received + r->overruns == EVENTS, "%s reader: %llu received + %llu overruns != %llu", which,
+            static_cast<unsigned long long>(r->received), static_cast<unsigned long long>(r->overruns), static_cast<unsigned long long>(EVENTS));
+    }
+    for (const ReaderResult* r : { &sh->fast, &sh->slow, &sh->stopped }) {
+        CHECK(r->restarts == 1 && r->afterRestart == RESTART_EVENTS && r->afterRestartInOrder,
+            "after restart: %llu restarts, %llu events, in order %d", static_cast<unsigned long long>(r->restarts),
+            static_cast<unsigned long long>(r->afterRestart), r->afterRestartInOrder ? 1 : 0);
+    }
+
+    std::printf("writer: %llu events in %.2fs with one reader stopped\n", static_cast<unsigned long long>(EVENTS), writerSec);
+    std::printf("fast:    %llu received, %llu overruns\n", static_cast<unsigned long long>(f.received), static_cast<unsigned long long>(f.overruns));
+    std::printf("slow:    %llu received, %llu overruns\n", static_cast<unsigned long long>(sh->slow.received), static_cast<unsigned long long>(sh->slow.overruns));
+    std::printf("stopped: %llu received, %llu overruns\n", static_cast<unsigned long long>(sh->stopped.received), static_cast<unsigned long long>(sh->stopped.overruns));
+    restarted.close();
+    writer.close();
+    if (failures) { std::printf("%d check(s) failed\n", failures); return 1; }
+    std::printf("event stream checks passed\n");
+    return 0;
+}
@@ -0,0 +1,73 @@
+// Injection latency calibration and compensation (injection_latency.h) on the
+// Linux stand-in for the input stack: PipeLoopback delivers each "injected"
+// event through a pipe to a timestamping reader thread. Every kind also gets a
+// simulated path delay (the real click path moves the cursor and sleeps 2 ms
+// before the button event). The profile is calibrated exactly as the GUI does,
+// then a click sequence is played without and with compensation and the
+// residual is reported by ResidualTracker.
+// Build and run from recordGui/:
+//   g++ -std=c++17 -O2 -I. tools/injection_latency_bench.cpp -o injection_latency_bench -pthread
+//   ./injection_latency_bench
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+#include "injection_latency.h"
+
+static const size_t PROBES = 40;
+static const size_t CLICKS = 50;
+static const auto SPACING = std::chrono::milliseconds(5);
+
+// Extra delay of each simulated path before the event reaches the pipe.
+static std::chrono::microseconds pathDelay(InjectKind k) {
+    switch (k) {
+        case InjectKind::BUTTON_CLICK: return std::chrono::microseconds(2000);
+        case InjectKind::BUTTON_RIGHT: return std::chrono::microseconds(200);
+        default:                       return std::chrono::microseconds(0);
+    }
+}
+
+// Plays CLICKS click events on a fixed grid, each sent early by `lead`, and
+// matches arrivals to their intended instants.
+static ResidualTracker::Summary playClicks(PipeLoopback& pipe, LoopbackSink& sink, double lead) {
+    ResidualTracker residuals;
+    auto start = LatencyClock::now() + std::chrono::milliseconds(10);
+    for (size_t i = 0; i < CLICKS; ++i) {
+        auto intended = start + SPACING * static_cast<int>(i);
+        std::this_thread::sleep_until(intended - std::chrono::microseconds(static_cast<long long>(lead * 1e6)));
+        residuals.expect(ArrivalClass::BUTTON, intended);
+        uint64_t seen = sink.count(ArrivalClass::BUTTON);
+        std::this_thread::sleep_for(pathDelay(InjectKind::BUTTON_CLICK));
+        pipe.send(ArrivalClass::BUTTON);
+        LatencyClock::time_point at;
+        if (sink.waitAfter(ArrivalClass::BUTTON, seen, std::chrono::milliseconds(100), at)) residuals.record(ArrivalClass::BUTTON, at);
+    }
+    return residuals.summary(ArrivalClass::BUTTON);
+}
+
+int main() {
+    LoopbackSink sink;
+    PipeLoopback pipe(sink);
+    if (!pipe.start()) { std::printf("pipe() failed\n"); return 1; }
+    std::atomic<bool> running{true};
+
+    LatencyProfile profile = calibrateInjectionLatency([&](InjectKind kind, size_t) {
+        std::this_thread::sleep_for(pathDelay(kind));
+        pipe.send(arrivalClassOf(kind));
+    }, sink, PROBES, SPACING, running);
+
+    std::printf("calibrated latency (median / p10-p90 spread):\n");
+    for (size_t k = 0; k < INJECT_KIND_COUNT; ++k) {
+        InjectKind kind = static_cast<InjectKind>(k);
+        std::printf("  %-14s %6.3f / %6.3f ms  simulated path %.3f ms  (%zu samples)\n", injectKindName(kind),
+            profile.latency[k] * 1e3, profile.jitter[k] * 1e3, pathDelay(kind).count() / 1e3, profile.samples[k]);
+    }
+
+    ResidualTracker::Summary raw = playClicks(pipe, sink, 0.0);
+    ResidualTracker::Summary comp = playClicks(pipe, sink, profile.lead(InjectKind::BUTTON_CLICK));
+    std::printf("click residual (mean / mean abs / max abs):\n");
+    std::printf("  uncompensated  %+6.3f / %6.3f / %6.3f ms  (%zu)\n", raw.mean * 1e3, raw.meanAbs * 1e3, raw.maxAbs * 1e3, raw.samples);
+    std::printf("  compensated    %+6.3f / %6.3f / %6.3f ms  (%zu)\n", comp.mean * 1e3, comp.meanAbs * 1e3, comp.maxAbs * 1e3, comp.samples);
+    pipe.stop();
+    return 0;
+}
@@ -0,0 +1,66 @@
+// Checks for the loop detector (loop_detector.h): uncorrelated input must not
+// be proposed as a loop, a repeating one must be found at its period.
+// Platform-neutral; build and run from recordGui/:
+//   g++ -std=c++17 -O2 -I. tools/loop_check.cpp -o loop_check && ./loop_check
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include "loop_detector.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { if (!(cond)) { std::printf("FAIL %s:%d: ", __FILE__, __LINE__); std::printf(__VA_ARGS__); std::printf("\n"); failures++; } } while (0)
+
+static Action delta(double t, double dx, double dy) {
+    Action a;
+    a.time = t;
+    a.type = ActionType::MOUSE_DELTA;
+    a.deltaX = dx; a.deltaY = dy;
+    a.isRawDelta = true;
+    return a;
+}
+
+// 60 s of white-noise mouse deltas at 100 Hz.
+static void checkNoiseRejected() {
+    for (unsigned seed = 1; seed <= 5; ++seed) {
+        std::mt19937 rng(seed);
+        std::normal_distribution<double> d(0.0, 5.0);
+        std::vector<Action> ev;
+        for (int i = 0; i < 6000; ++i) ev.push_back(delta(i * 0.01, d(rng), d(rng)));
+        LoopCandidate c = detectLoop(ev);
+        CHECK(!c.found, "seed %u: noise accepted as a %.2fs loop (correlation %.2f)", seed, c.period, c.correlation);
+    }
+}
+
+// Ten repeats of a 3 s stroke with a key tap, plus a little noise.
+static void checkPeriodicAccepted() {
+    std::mt19937 rng(7);
+    std::normal_distribution<double> jitter(0.0, 0.5);
+    std::vector<Action> ev;
+    for (int i = 0; i < 3000; ++i) {
+        double t = i * 0.01;
+        double phase = std::fmod(t, 3.0) / 3.0;
+        ev.push_back(delta(t, 8.0 * std::sin(2 * 3.14159265358979 * phase) + jitter(rng), (phase < 0.5 ? 3.0 : -3.0) + jitter(rng)));
+        if (i % 300 == 100) {
+            Action k; k.time = t; k.type = ActionType::KEY_PRESS; k.vkCode = 87; k.key = "W";
+            ev.push_back(k);
+        } else if (i % 300 == 150) {
+            Action k; k.time = t; k.type = ActionType::KEY_RELEASE; k.vkCode = 87; k.key = "W";
+            ev.push_back(k);
+        }
+    }
+    LoopCandidate c = detectLoop(ev);
+    CHECK(c.found, "periodic trace rejected");
+    CHECK(std::abs(c.period - 3.0) < 2 * LOOP_BIN_SEC, "period %.2fs, expected 3.00s", c.period);
+    CHECK(c.correlation >= LOOP_MIN_CORRELATION, "correlation %.2f", c.correlation);
+    CHECK(c.heldAtCut == 0, "%zu keys held at the cut", c.heldAtCut);
+}
+
+int main() {
+    checkNoiseRejected();
+    checkPeriodicAccepted();
+    if (failures) { std::printf("%d check(s) failed\n", failures); return 1; }
+    std::printf("loop checks passed\n");
+    return 0;
+}
@@ -0,0 +1,46 @@
+// Wakeup lateness of a 1 ms absolute-deadline loop (the playback timing
+// pattern) with and without a real-time policy, while every CPU is kept busy
+// by twice as many spinning threads. Linux; SCHED_FIFO needs root or
+// CAP_SYS_NICE, otherwise the "applied" column reads 0 and both rows match.
+// Build and run from recordGui/:
+//   g++ -std=c++17 -O2 -I. tools/sched_lateness_bench.cpp -o sched_lateness_bench -pthread
+//   sudo ./sched_lateness_bench [iterations] [thread_policy.json]
+// With a policy file, its "playback" entry is measured instead of plain SCHED_FIFO.
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+#include "thread_policy.h"
+
+static void print(const char* name, const LatenessStats& s) {
+    std::printf("%-10s applied %d  mean %7.1f  p50 %7.1f  p99 %7.1f  max %8.1f us  (%zu samples)\n",
+        name, s.policyApplied ? 1 : 0, s.meanUs, s.p50Us, s.p99Us, s.maxUs, s.samples);
+}
+
+int main(int argc, char** argv) {
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    ThreadPolicy rt;
+    rt.realtime = true;
+    rt.rtPriority = 80;
+    if (argc > 2) rt = loadThreadPolicyConfig(argv[2]).playback;
+    const auto period = std::chrono::microseconds(1000);
+
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> hogs;
+    unsigned n = std::max(1u, std::thread::hardware_concurrency()) * 2;
+    for (unsigned i = 0; i < n; ++i) {
+        hogs.emplace_back([&stop]() { volatile double x = 0; while (!stop) x = x + 1; });
+    }
+    LatenessStats normal = measureSchedulingLateness(ThreadPolicy{}, period, iterations);
+    LatenessStats realtime = measureSchedulingLateness(rt, period, iterations);
+    stop = true;
+    for (auto& h : hogs) h.join();
+
+    std::printf("1 ms loop, %u spinning threads\n", n);
+    print("normal", normal);
+    print("realtime", realtime);
+    return 0;
+}
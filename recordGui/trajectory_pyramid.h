@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "recording.h"
+#include "recording_slice.h"
+
+static const double   PYRAMID_BASE_SEC     = 0.01;          // finest level-0 bucket width
+static const size_t   PYRAMID_BASE_BUCKETS = 4096;          // level-0 cap; the preview draws a few hundred columns
+static const uint32_t PYRAMID_MAGIC        = 0x44495950;    // "PYID"
+static const uint32_t PYRAMID_VERSION      = 2;
+
+// One time bucket of the cumulative cursor path (MOUSE_MOVE/MOUSE_DELTA deltas
+// summed from 0) and of key/button activity.
+struct PyramidBucket {
+    float minX, maxX, minY, maxY;   // path envelope inside the bucket
+    float sumDx, sumDy;             // motion inside the bucket
+    uint32_t presses;               // key and button presses
+    uint16_t maxHeld;               // most keys/buttons down at once
+    uint16_t reserved;
+
+    static PyramidBucket at(float x, float y) {
+        return { x, x, y, y, 0.0f, 0.0f, 0, 0, 0 };
+    }
+
+    void merge(const PyramidBucket& o) {
+        minX = std::min(minX, o.minX); maxX = std::max(maxX, o.maxX);
+        minY = std::min(minY, o.minY); maxY = std::max(maxY, o.maxY);
+        sumDx += o.sumDx; sumDy += o.sumDy;
+        presses += o.presses;
+        maxHeld = std::max(maxHeld, o.maxHeld);
+    }
+};
+
+// Level-of-detail pyramid: level 0 has PYRAMID_BASE_SEC buckets, widened so there
+// are at most PYRAMID_BASE_BUCKETS of them, and each next level halves the count
+// by merging pairs, up to a single bucket. Any time range can then be drawn from
+// the coarsest level that still has at least one bucket per pixel, so rendering
+// costs O(pixels) whatever the recording length, and the sidecar stays ~256 KB.
+class TrajectoryPyramid {
+    std::vector<std::vector<PyramidBucket>> levels;
+    double duration = 0.0;
+    double baseSec = PYRAMID_BASE_SEC;
+
+public:
+    double length() const { return duration; }
+    bool empty() const { return levels.empty(); }
+    size_t levelCount() const { return levels.size(); }
+    const PyramidBucket& whole() const { return levels.back().front(); }
+
+    static TrajectoryPyramid build(const std::vector<Action>& events) {
+        TrajectoryPyramid p;
+        if (events.empty()) return p;
+        double t0 = events.front().time;
+        p.duration = events.back().time - t0;
+        p.baseSec = std::max(PYRAMID_BASE_SEC, p.duration / (PYRAMID_BASE_BUCKETS - 1));
+        size_t n = std::min(PYRAMID_BASE_BUCKETS, static_cast<size_t>(p.duration / p.baseSec) + 1);
+        std::vector<PyramidBucket> base;
+        base.reserve(n);
+        float x = 0.0f, y = 0.0f;
+        HeldState held;
+        size_t e = 0;
+        for (size_t b = 0; b < n; ++b) {
+            PyramidBucket bk = PyramidBucket::at(x, y);
+            bk.maxHeld = static_cast<uint16_t>(held.count());
+            double end = b + 1 == n ? events.back().time + 1.0 : t0 + (b + 1) * p.baseSec;
+            for (; e < events.size() && events[e].time < end; ++e) {
+                const Action& a = events[e];
+                if (a.type == ActionType::MOUSE_MOVE || a.type == ActionType::MOUSE_DELTA) {
+                    x += static_cast<float>(a.deltaX); y += static_cast<float>(a.deltaY);
+                    bk.sumDx += static_cast<float>(a.deltaX); bk.sumDy += static_cast<float>(a.deltaY);
+                    bk.minX = std::min(bk.minX, x); bk.maxX = std::max(bk.maxX, x);
+                    bk.minY = std::min(bk.minY, y); bk.maxY = std::max(bk.maxY, y);
+                } else if (a.type == ActionType::KEY_PRESS || a.type == ActionType::MOUSE_PRESS) {
+                    bk.presses++;
+                }
+                held.apply(a);
+                bk.maxHeld = std::max(bk.maxHeld, static_cast<uint16_t>(held.count()));
+            }
+            base.push_back(bk);
+        }
+        p.levels.push_back(std::move(base));
+        while (p.levels.back().size() > 1) {
+            const auto& prev = p.levels.back();
+            std::vector<PyramidBucket> next((prev.size() + 1) / 2);
+            for (size_t i = 0; i < next.size(); ++i) {
+                next[i] = prev[2 * i];
+                if (2 * i + 1 < prev.size()) next[i].merge(prev[2 * i + 1]);
+            }
+            p.levels.push_back(std::move(next));
+        }
+        return p;
+    }
+
+    // Buckets covering [t0, t1) (seconds from the recording start), resampled to
+    // exactly `columns` entries. Reads at most ~2 buckets per column.
+    std::vector<PyramidBucket> query(double t0, double t1, size_t columns) const {
+        std::vector<PyramidBucket> out;
+        if (levels.empty() || columns == 0 || t1 <= t0) return out;
+        double perColumn = (t1 - t0) / columns;
+        size_t level = 0;
+        while (level + 1 < levels.size() && baseSec * (2ull << level) <= perColumn) ++level;
+        const auto& lv = levels[level];
+        double width = baseSec * (1ull << level);
+        out.reserve(columns);
+        for (size_t c = 0; c < columns; ++c) {
+            double cs = t0 + c * perColumn, ce = cs + perColumn;
+            long long first = static_cast<long long>(std::floor(cs / width));
+            long long last = static_cast<long long>(std::ceil(ce / width)) - 1;
+            first = std::max(0ll, std::min(first, static_cast<long long>(lv.size()) - 1));
+            last = std::max(first, std::min(last, static_cast<long long>(lv.size()) - 1));
+            PyramidBucket bk = lv[first];
+            for (long long i = first + 1; i <= last; ++i) bk.merge(lv[i]);
+            out.push_back(bk);
+        }
+        return out;
+    }
+
+    // Sidecar "<recording>.pyr", keyed on the recording's size and mtime.
+    static std::string cachePath(const std::string& recordingPath) { return recordingPath + ".pyr"; }
+
+    bool save(const std::string& recordingPath) const {
+        try {
+            namespace fs = std::filesystem;
+            std::ofstream f(cachePath(recordingPath), std::ios::binary);
+            uint64_t srcSize = fs::file_size(recordingPath);
+            int64_t srcTime = static_cast<int64_t>(fs::last_write_time(recordingPath).time_since_epoch().count());
+            uint32_t count = static_cast<uint32_t>(levels.size());
+            f.write(reinterpret_cast<const char*>(&PYRAMID_MAGIC), sizeof(PYRAMID_MAGIC));
+            f.write(reinterpret_cast<const char*>(&PYRAMID_VERSION), sizeof(PYRAMID_VERSION));
+            f.write(reinterpret_cast<const char*>(&srcSize), sizeof(srcSize));
+            f.write(reinterpret_cast<const char*>(&srcTime), sizeof(srcTime));
+            f.write(reinterpret_cast<const char*>(&duration), sizeof(duration));
+            f.write(reinterpret_cast<const char*>(&baseSec), sizeof(baseSec));
+            f.write(reinterpret_cast<const char*>(&count), sizeof(count));
+            for (const auto& lv : levels) {
+                uint64_t size = lv.size();
+                f.write(reinterpret_cast<const char*>(&size), sizeof(size));
+                f.write(reinterpret_cast<const char*>(lv.data()), static_cast<std::streamsize>(size * sizeof(PyramidBucket)));
+            }
+            return static_cast<bool>(f);
+        } catch (...) { return false; }
+    }
+
+    bool load(const std::string& recordingPath) {
+        try {
+            namespace fs = std::filesystem;
+            std::ifstream f(cachePath(recordingPath), std::ios::binary);
+            if (!f) return false;
+            uint32_t magic = 0, version = 0, count = 0;
+            uint64_t srcSize = 0;
+            int64_t srcTime = 0;
+            f.read(reinterpret_cast<char*>(&magic), sizeof(magic));
+            f.read(reinterpret_cast<char*>(&version), sizeof(version));
+            f.read(reinterpret_cast<char*>(&srcSize), sizeof(srcSize));
+            f.read(reinterpret_cast<char*>(&srcTime), sizeof(srcTime));
+            if (!f || magic != PYRAMID_MAGIC || version != PYRAMID_VERSION) return false;
+            if (srcSize != fs::file_size(recordingPath)) return false;
+            if (srcTime != static_cast<int64_t>(fs::last_write_time(recordingPath).time_since_epoch().count())) return false;
+            double storedDuration = 0.0, storedBase = 0.0;
+            f.read(reinterpret_cast<char*>(&storedDuration), sizeof(storedDuration));
+            f.read(reinterpret_cast<char*>(&storedBase), sizeof(storedBase));
+            f.read(reinterpret_cast<char*>(&count), sizeof(count));
+            if (!f || count > 64 || !(storedBase >= PYRAMID_BASE_SEC)) return false;
+            std::vector<std::vector<PyramidBucket>> loaded(count);
+            for (auto& lv : loaded) {
+                uint64_t size = 0;
+                f.read(reinterpret_cast<char*>(&size), sizeof(size));
+                if (!f || size == 0 || size > PYRAMID_BASE_BUCKETS) return false;
+                lv.resize(size);
+                f.read(reinterpret_cast<char*>(lv.data()), static_cast<std::streamsize>(size * sizeof(PyramidBucket)));
+            }
+            if (!f || loaded.empty() || loaded.back().size() != 1) return false;
+            levels.swap(loaded);
+            duration = storedDuration;
+            baseSec = storedBase;
+            return true;
+        } catch (...) { return false; }
+    }
+};